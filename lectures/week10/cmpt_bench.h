@@ -0,0 +1,251 @@
+// cmpt_bench.h
+
+// By defining CMPT_BENCH_H, we avoid including this file more than once: if
+// CMPT_BENCH_H is already defined, then the code is *not* included.
+#ifndef CMPT_BENCH_H
+#define CMPT_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace cmpt {
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Bench is a helper class for timing code, e.g. sorting functions. It runs the
+// code a few times without timing it (the warm-up), and then times it a number
+// of times (the repetitions) and reports statistics about the times. For
+// example:
+//
+//     #include "cmpt_bench.h"
+//
+//     vector<int> data = random_vector(n);
+//     vector<int> v;
+//     cmpt::Bench bench;
+//     bench.run("Mergesort", n,
+//               [&]() { v = data; },       // setup: not timed
+//               [&]() { mergesort(v); });  // timed
+//     bench.run("Insertion sort", n,
+//               [&]() { v = data; },
+//               [&]() { insertion_sort(v); });
+//     bench.print_table(cout);  // or print_csv, or print_json
+//
+// Setup is called before every repetition, so in this example each sort gets
+// its own unsorted copy of data.
+//
+// The median time is reported instead of the average, since one slow
+// repetition (e.g. because another program was running) can change the average
+// a lot but barely changes the median.
+//
+// To see how the time grows with n, call run for different values of n, e.g.
+// for every n in sweep(1000, 1000000).
+//
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace std;
+
+// The results of timing one piece of code.
+struct Bench_result {
+    string name;
+    long n;                 // number of elements processed per repetition
+    vector<double> times;   // time of each repetition in ms, in sorted order
+    double count;           // average value of the counter, or -1 if there
+                            // is no counter
+
+    // returns the p-th percentile time in ms, for 0 <= p <= 100
+    double percentile(double p) const;
+
+    double min() const { return percentile(0); }
+    double median() const { return percentile(50); }
+    double max() const { return percentile(100); }
+    double mean() const;
+
+    // elements per second, based on the median time
+    double throughput() const;
+};
+
+class Bench {
+private:
+    int reps;
+    int warmup;
+    vector<Bench_result> results;
+
+public:
+    static const int default_reps = 10;
+    static const int default_warmup = 1;
+
+    Bench(int reps, int warmup);
+    Bench();
+
+    // Times body reps times, after calling it warmup times without timing it.
+    // setup is called, and not timed, before every call to body. If counter is
+    // not nullptr then it is set to 0 before each timed call to body, and the
+    // average of its values after the calls is saved in the result as count.
+    const Bench_result &run(const string &name, long n,
+                            const function<void()> &setup,
+                            const function<void()> &body,
+                            long *counter = nullptr);
+
+    const vector<Bench_result> &get_results() const;
+    void clear();
+
+    void print_table(ostream &out) const;
+    void print_csv(ostream &out) const;
+    void print_json(ostream &out) const;
+}; // class Bench
+
+// returns first, 2 * first, 4 * first, ..., up to and including last (if it's
+// in the sequence); use it to run the same benchmark at many sizes
+vector<long> sweep(long first, long last, long factor = 2);
+
+//
+// implementation
+//
+
+inline double Bench_result::percentile(double p) const {
+    if (times.empty()) return 0;
+    // the time p percent of the way from the fastest to the slowest, rounded
+    // to the nearest one (not interpolated between two times)
+    int i = round(p / 100 * (times.size() - 1));
+    return times[i];
+}
+
+inline double Bench_result::mean() const {
+    double total = 0;
+    for (double t : times) total += t;
+    return times.empty() ? 0 : total / times.size();
+}
+
+inline double Bench_result::throughput() const {
+    double ms = median();
+    return ms > 0 ? n / (ms / 1000) : 0;
+}
+
+inline Bench::Bench(int reps, int warmup)
+: reps(std::max(1, reps)), warmup(std::max(0, warmup))
+{ }
+
+inline Bench::Bench()
+: Bench{default_reps, default_warmup}
+{ }
+
+inline const Bench_result &Bench::run(const string &name, long n,
+                                      const function<void()> &setup,
+                                      const function<void()> &body,
+                                      long *counter)
+{
+    for (int i = 0; i < warmup; i++) {
+        setup();
+        body();
+    }
+
+    Bench_result r{name, n, {}, -1};
+    double total_count = 0;
+    for (int i = 0; i < reps; i++) {
+        setup();
+        if (counter != nullptr) *counter = 0;
+        auto start = chrono::steady_clock::now();
+        body();
+        auto stop = chrono::steady_clock::now();
+        chrono::duration<double, milli> ms = stop - start;
+        r.times.push_back(ms.count());
+        if (counter != nullptr) total_count += *counter;
+    }
+    sort(r.times.begin(), r.times.end());
+    if (counter != nullptr) r.count = total_count / reps;
+
+    results.push_back(r);
+    return results.back();
+}
+
+inline const vector<Bench_result> &Bench::get_results() const {
+    return results;
+}
+
+inline void Bench::clear() {
+    results.clear();
+}
+
+inline void Bench::print_table(ostream &out) const {
+    // save the formatting of out so it can be restored at the end
+    ios_base::fmtflags old_flags = out.flags();
+    streamsize old_precision = out.precision();
+
+    out << left << setw(28) << "Name"
+        << right << setw(12) << "n"
+        << setw(16) << "Count"
+        << setw(12) << "Min (ms)"
+        << setw(12) << "Median (ms)"
+        << setw(12) << "p90 (ms)"
+        << setw(14) << "Elements/s" << "\n";
+    for (const Bench_result &r : results) {
+        out << left << setw(28) << r.name
+            << right << setw(12) << r.n;
+        if (r.count >= 0)
+            out << setw(16) << fixed << setprecision(0) << r.count;
+        else
+            out << setw(16) << "-";
+        out << fixed << setprecision(3)
+            << setw(12) << r.min()
+            << setw(12) << r.median()
+            << setw(12) << r.percentile(90)
+            << setw(14) << scientific << setprecision(3) << r.throughput()
+            << defaultfloat << "\n";
+    }
+
+    out.flags(old_flags);
+    out.precision(old_precision);
+}
+
+inline void Bench::print_csv(ostream &out) const {
+    out << "name,n,reps,count,min_ms,p10_ms,median_ms,p90_ms,max_ms,"
+        << "mean_ms,elements_per_sec\n";
+    for (const Bench_result &r : results) {
+        out << "\"" << r.name << "\"," << r.n << "," << r.times.size() << ",";
+        if (r.count >= 0) out << lround(r.count);
+        out << "," << r.min() << "," << r.percentile(10) << ","
+            << r.median() << "," << r.percentile(90) << "," << r.max() << ","
+            << r.mean() << "," << r.throughput() << "\n";
+    }
+}
+
+inline void Bench::print_json(ostream &out) const {
+    out << "[\n";
+    for (int i = 0; i < results.size(); i++) {
+        const Bench_result &r = results[i];
+        out << "  {\"name\": \"" << r.name << "\", \"n\": " << r.n
+            << ", \"reps\": " << r.times.size()
+            << ", \"count\": ";
+        if (r.count >= 0)
+            out << lround(r.count);
+        else
+            out << "null";
+        out << ", \"min_ms\": " << r.min()
+            << ", \"p10_ms\": " << r.percentile(10)
+            << ", \"median_ms\": " << r.median()
+            << ", \"p90_ms\": " << r.percentile(90)
+            << ", \"max_ms\": " << r.max()
+            << ", \"mean_ms\": " << r.mean()
+            << ", \"elements_per_sec\": " << r.throughput() << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+}
+
+inline vector<long> sweep(long first, long last, long factor) {
+    vector<long> result;
+    for (long n = std::max(1L, first); n <= last; n *= std::max(2L, factor)) {
+        result.push_back(n);
+    }
+    return result;
+}
+
+} // namespace cmpt
+
+#endif
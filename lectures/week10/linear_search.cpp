@@ -1,9 +1,23 @@
 // linear_search.cpp
 
+//
+// Runs the tests. With the option --bench it instead times the searches on
+// vectors of 1024 up to max_n ints (default 2^24):
+//
+//   > ./linear_search --bench [max_n]
+//
+
+#include "cmpt_bench.h"
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 #include <vector>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 // Pre-condition:
@@ -260,8 +274,381 @@ void test_linear_search4()
     cout << " ... test_linear_search4 done: all tests passed\n";
 }
 
-int main()
+//
+// SIMD linear search
+//
+// All the linear searches above compare one element per loop iteration. Most
+// CPUs have SIMD (single instruction, multiple data) instructions that compare
+// many elements at once: SSE2 instructions work on 16 bytes at a time (4 ints
+// or 16 chars), and AVX2 instructions on 32 bytes at a time (8 ints or 32
+// chars). Each comparison gives a bit mask with one bit per element that is
+// equal to x, so the first (or, for a reverse search, last) match is the
+// lowest (or highest) set bit. The elements left over at the end that don't
+// fill a whole vector are searched one at a time.
+//
+// Not every CPU has these instructions, so the program checks when it starts
+// which ones the CPU supports, and then always calls the fastest version of
+// each search that can run.
+//
+
+// the plain versions, used if the CPU has no SSE2 or AVX2
+
+int find_scalar(const int *p, int n, int x)
+{
+    for (int i = 0; i < n; i++)
+    {
+        if (p[i] == x)
+            return i;
+    }
+    return -1;
+}
+
+int rfind_scalar(const int *p, int n, int x)
+{
+    for (int i = n - 1; i >= 0; i--)
+    {
+        if (p[i] == x)
+            return i;
+    }
+    return -1;
+}
+
+int find_scalar(const char *p, int n, char c)
+{
+    for (int i = 0; i < n; i++)
+    {
+        if (p[i] == c)
+            return i;
+    }
+    return -1;
+}
+
+int rfind_scalar(const char *p, int n, char c)
+{
+    for (int i = n - 1; i >= 0; i--)
+    {
+        if (p[i] == c)
+            return i;
+    }
+    return -1;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// SSE2 versions: 4 ints or 16 chars per comparison
+
+__attribute__((target("sse2"))) int find_sse2(const int *p, int n, int x)
+{
+    const __m128i key = _mm_set1_epi32(x);
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128i *in = reinterpret_cast<const __m128i *>(p + i);
+        __m128i values = _mm_loadu_si128(in);
+        __m128i equal = _mm_cmpeq_epi32(values, key);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    int j = find_scalar(p + i, n - i, x);
+    return j < 0 ? -1 : i + j;
+}
+
+__attribute__((target("sse2"))) int rfind_sse2(const int *p, int n, int x)
+{
+    const __m128i key = _mm_set1_epi32(x);
+    int i = n;
+    for (; i >= 4; i -= 4)
+    {
+        const __m128i *in = reinterpret_cast<const __m128i *>(p + i - 4);
+        __m128i values = _mm_loadu_si128(in);
+        __m128i equal = _mm_cmpeq_epi32(values, key);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        if (mask != 0)
+            return i - 4 + 31 - __builtin_clz(mask);
+    }
+    return rfind_scalar(p, i, x);
+}
+
+__attribute__((target("sse2"))) int find_sse2(const char *p, int n, char c)
 {
+    const __m128i key = _mm_set1_epi8(c);
+    int i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i *in = reinterpret_cast<const __m128i *>(p + i);
+        __m128i values = _mm_loadu_si128(in);
+        __m128i equal = _mm_cmpeq_epi8(values, key);
+        int mask = _mm_movemask_epi8(equal);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    int j = find_scalar(p + i, n - i, c);
+    return j < 0 ? -1 : i + j;
+}
+
+__attribute__((target("sse2"))) int rfind_sse2(const char *p, int n, char c)
+{
+    const __m128i key = _mm_set1_epi8(c);
+    int i = n;
+    for (; i >= 16; i -= 16)
+    {
+        const __m128i *in = reinterpret_cast<const __m128i *>(p + i - 16);
+        __m128i values = _mm_loadu_si128(in);
+        __m128i equal = _mm_cmpeq_epi8(values, key);
+        int mask = _mm_movemask_epi8(equal);
+        if (mask != 0)
+            return i - 16 + 31 - __builtin_clz(mask);
+    }
+    return rfind_scalar(p, i, c);
+}
+
+// AVX2 versions: 8 ints or 32 chars per comparison
+
+__attribute__((target("avx2"))) int find_avx2(const int *p, int n, int x)
+{
+    const __m256i key = _mm256_set1_epi32(x);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i *in = reinterpret_cast<const __m256i *>(p + i);
+        __m256i values = _mm256_loadu_si256(in);
+        __m256i equal = _mm256_cmpeq_epi32(values, key);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    int j = find_scalar(p + i, n - i, x);
+    return j < 0 ? -1 : i + j;
+}
+
+__attribute__((target("avx2"))) int rfind_avx2(const int *p, int n, int x)
+{
+    const __m256i key = _mm256_set1_epi32(x);
+    int i = n;
+    for (; i >= 8; i -= 8)
+    {
+        const __m256i *in = reinterpret_cast<const __m256i *>(p + i - 8);
+        __m256i values = _mm256_loadu_si256(in);
+        __m256i equal = _mm256_cmpeq_epi32(values, key);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal));
+        if (mask != 0)
+            return i - 8 + 31 - __builtin_clz(mask);
+    }
+    return rfind_scalar(p, i, x);
+}
+
+__attribute__((target("avx2"))) int find_avx2(const char *p, int n, char c)
+{
+    const __m256i key = _mm256_set1_epi8(c);
+    int i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i *in = reinterpret_cast<const __m256i *>(p + i);
+        __m256i values = _mm256_loadu_si256(in);
+        __m256i equal = _mm256_cmpeq_epi8(values, key);
+        unsigned mask = _mm256_movemask_epi8(equal);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+    int j = find_scalar(p + i, n - i, c);
+    return j < 0 ? -1 : i + j;
+}
+
+__attribute__((target("avx2"))) int rfind_avx2(const char *p, int n, char c)
+{
+    const __m256i key = _mm256_set1_epi8(c);
+    int i = n;
+    for (; i >= 32; i -= 32)
+    {
+        const __m256i *in = reinterpret_cast<const __m256i *>(p + i - 32);
+        __m256i values = _mm256_loadu_si256(in);
+        __m256i equal = _mm256_cmpeq_epi8(values, key);
+        unsigned mask = _mm256_movemask_epi8(equal);
+        if (mask != 0)
+            return i - 32 + 31 - __builtin_clz(mask);
+    }
+    return rfind_scalar(p, i, c);
+}
+
+#endif
+
+// A pointer to one of the search functions above, e.g. find_sse2 for ints is a
+// Search_fn<int>. T is int or char.
+template <typename T>
+using Search_fn = int (*)(const T *, int, T);
+
+// Returns the fastest version of a search that this CPU supports.
+template <typename T>
+Search_fn<T> choose_search(Search_fn<T> avx2, Search_fn<T> sse2,
+                           Search_fn<T> scalar)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2"))
+        return avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return sse2;
+#endif
+    return scalar;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+const Search_fn<int> find_int =
+    choose_search<int>(find_avx2, find_sse2, find_scalar);
+const Search_fn<int> rfind_int =
+    choose_search<int>(rfind_avx2, rfind_sse2, rfind_scalar);
+const Search_fn<char> find_char =
+    choose_search<char>(find_avx2, find_sse2, find_scalar);
+const Search_fn<char> rfind_char =
+    choose_search<char>(rfind_avx2, rfind_sse2, rfind_scalar);
+#else
+const Search_fn<int> find_int = find_scalar;
+const Search_fn<int> rfind_int = rfind_scalar;
+const Search_fn<char> find_char = find_scalar;
+const Search_fn<char> rfind_char = rfind_scalar;
+#endif
+
+// Same as linear_search1: returns the smallest i >= 0 such that v[i] == x, or
+// -1 if x is not in v.
+int simd_linear_search(const vector<int> &v, int x)
+{
+    return find_int(v.data(), v.size(), x);
+}
+
+// Same as linear_search1a: returns the smallest i >= 0 such that s[i] == c, or
+// -1 if c is not in s.
+int simd_linear_search(const string &s, char c)
+{
+    return find_char(s.data(), s.size(), c);
+}
+
+// Same as reverse_linear_search: returns the biggest i such that v[i] == x, or
+// -1 if x is not in v.
+int simd_reverse_linear_search(const vector<int> &v, int x)
+{
+    return rfind_int(v.data(), v.size(), x);
+}
+
+// returns the biggest i such that s[i] == c, or -1 if c is not in s
+int simd_reverse_linear_search(const string &s, char c)
+{
+    return rfind_char(s.data(), s.size(), c);
+}
+
+void test_simd_linear_search()
+{
+    cout << "Calling test_simd_linear_search ...\n";
+
+    // every version that can run on this CPU, not just the fastest one
+    vector<int (*)(const int *, int, int)> finds = {find_scalar};
+    vector<int (*)(const int *, int, int)> rfinds = {rfind_scalar};
+    vector<int (*)(const char *, int, char)> char_finds = {find_scalar};
+    vector<int (*)(const char *, int, char)> char_rfinds = {rfind_scalar};
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("sse2"))
+    {
+        finds.push_back(find_sse2);
+        rfinds.push_back(rfind_sse2);
+        char_finds.push_back(find_sse2);
+        char_rfinds.push_back(rfind_sse2);
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        finds.push_back(find_avx2);
+        rfinds.push_back(rfind_avx2);
+        char_finds.push_back(find_avx2);
+        char_rfinds.push_back(rfind_avx2);
+    }
+#endif
+
+    // every length up to a few vectors, with x missing, at one position, or
+    // at two positions
+    for (int n = 0; n <= 80; n++)
+    {
+        for (int i = -1; i < n; i++)
+        {
+            for (int j = i; j < n; j++)
+            {
+                vector<int> v(n, 0);
+                string s(n, 'a');
+                if (i >= 0)
+                {
+                    v[i] = 7;
+                    s[i] = 'x';
+                }
+                if (j >= 0)
+                {
+                    v[j] = 7;
+                    s[j] = 'x';
+                }
+                int first = i >= 0 ? i : j;
+                int last = j;
+
+                assert(linear_search1(v, 7) == first);
+                assert(reverse_linear_search(v, 7) == last);
+                for (int k = 0; k < finds.size(); k++)
+                {
+                    assert(finds[k](v.data(), n, 7) == first);
+                    assert(rfinds[k](v.data(), n, 7) == last);
+                    assert(char_finds[k](s.data(), n, 'x') == first);
+                    assert(char_rfinds[k](s.data(), n, 'x') == last);
+                }
+            }
+        }
+    }
+
+    // negative numbers and chars, whose sign bits are set
+    vector<int> v = {1, 2, -1, 3, 4, 5, 6, 7, 8, -1};
+    assert(simd_linear_search(v, -1) == 2);
+    assert(simd_reverse_linear_search(v, -1) == 9);
+    string s = "abc\xff" "defghijklmnopqrstuvwxyz0123456789\xff";
+    assert(simd_linear_search(s, '\xff') == 3);
+    assert(simd_reverse_linear_search(s, '\xff') == s.size() - 1);
+    assert(simd_linear_search(s, 'A') == -1);
+    assert(simd_reverse_linear_search(s, 'A') == -1);
+
+    cout << " ... test_simd_linear_search done: all tests passed\n";
+}
+
+// Times linear_search1, the sentinel search linear_search2, and
+// simd_linear_search on vectors of n ints from 1024 up to max_n, searching for
+// an int that isn't there (so the whole vector is searched), and prints a
+// table of the results. The Elements/s column is the number of ints searched
+// per second.
+void do_search_bench(int max_n)
+{
+    cmpt::Bench bench;
+    for (long n : cmpt::sweep(1024, max_n, 4))
+    {
+        vector<int> v(n);
+        for (int i = 0; i < n; i++)
+        {
+            v[i] = i;
+        }
+        const int x = -1;
+        long total = 0; // used so the searches can't be optimized away
+
+        bench.run("linear_search1", n, []() {},
+                  [&]() { total += linear_search1(v, x); });
+        bench.run("linear_search2 (sentinel)", n, []() {},
+                  [&]() { total += linear_search2(v, x); });
+        bench.run("simd_linear_search", n, []() {},
+                  [&]() { total += simd_linear_search(v, x); });
+        if (total > 0)
+            cout << "x was found\n";
+    }
+    bench.print_table(cout);
+} // do_search_bench
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 2 && string(argv[1]) == "--bench")
+    {
+        int max_n = argc >= 3 ? atoi(argv[2]) : 1 << 24;
+        do_search_bench(max_n);
+        return 0;
+    }
+
     test_linear_search1();
     test_linear_search1a();
     test_reverse_linear_search();
@@ -269,4 +656,5 @@ int main()
     test_linear_search3();
     test_linear_search3();
     test_linear_search4();
+    test_simd_linear_search();
 }
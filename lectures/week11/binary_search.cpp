@@ -1,7 +1,22 @@
 // binary_search.cpp
 
+//
+// Runs the tests. With the option --bench it instead times searching sorted
+// vectors of ints with binary_search_loop, binary_search_batch, and the
+// search indexes in cmpt_search.h, for vectors from 1024 ints (4 KB, which
+// fits in the fastest cache) up to max_n ints (default 2^26 ints, i.e. 256 MB,
+// which is bigger than the caches of most computers):
+//
+//   > ./binary_search --bench [max_n]
+//
+
+#include "cmpt_bench.h"
+#include "cmpt_search.h"
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 #include <vector>
 
 using namespace std;
@@ -44,6 +59,219 @@ int binary_search_loop(int x, const vector<int> &v)
     return binary_search_loop(x, v, 0, v.size());
 }
 
+// Number of searches binary_search_batch does at the same time.
+const int search_batch_size = 16;
+
+// Pre-condition:
+//    v is in ascending sorted order
+// Post-condition:
+//    returns a vector r such that r[i] == binary_search_loop(queries[i], v)
+//    for every i
+//
+// On a big v, every step of binary_search_loop is usually a cache miss, and
+// the CPU can't start the next step until the miss is done. So instead of
+// finishing one search before starting the next, this does the searches in
+// groups of search_batch_size. First it asks the CPU to start loading
+// (prefetch) the middle value of every search in the group, and then it does
+// one step of every search. The cache misses of the group happen at the same
+// time instead of one after the other. Each search makes exactly the same
+// steps as binary_search_loop, and so gives the same answer.
+vector<int> binary_search_batch(const vector<int> &queries,
+                                const vector<int> &v)
+{
+    const int n = queries.size();
+    vector<int> result(n, -1);
+    for (int first = 0; first < n; first += search_batch_size)
+    {
+        const int m = min(search_batch_size, n - first);
+        int begin[search_batch_size];
+        int end[search_batch_size];
+        for (int i = 0; i < m; i++)
+        {
+            begin[i] = 0;
+            end[i] = v.size();
+        }
+
+        bool searching = true;
+        while (searching)
+        {
+            for (int i = 0; i < m; i++)
+            {
+                if (begin[i] < end[i])
+                    __builtin_prefetch(v.data() + (begin[i] + end[i]) / 2);
+            }
+
+            searching = false;
+            for (int i = 0; i < m; i++)
+            {
+                if (begin[i] >= end[i])
+                    continue; // this search is done
+                int x = queries[first + i];
+                int mid = (begin[i] + end[i]) / 2;
+                if (v[mid] == x)
+                { // found x!
+                    result[first + i] = mid;
+                    end[i] = begin[i];
+                }
+                else if (x < v[mid])
+                {
+                    end[i] = mid;
+                }
+                else // x > v[mid]
+                {
+                    begin[i] = mid + 1;
+                }
+                if (begin[i] < end[i])
+                    searching = true;
+            }
+        } // while
+    }
+    return result;
+} // binary_search_batch
+
+// Pre-condition:
+//    v is in ascending sorted order
+// Post-condition:
+//    returns an index i such that v[i] == x; if x is not in v, -1 is returned
+//
+// Binary search always checks the middle of the range. If the values are
+// spread out evenly (e.g. v = {10, 20, 30, ...}) it's better to guess where x
+// should be from its value, like looking up a word starting with "s" near the
+// end of a dictionary rather than in the middle. On evenly spread values this
+// takes about log2(log2(n)) steps instead of log2(n).
+//
+// On unevenly spread values the guesses can be bad, and cut off only a few
+// values each time. So whenever a guess doesn't at least halve the range, the
+// next step is a normal binary search step. That guarantees at most about
+// 2 * log2(n) steps, no matter what the values are.
+int interpolation_search(int x, const vector<int> &v)
+{
+    int begin = 0;
+    int end = v.size();
+    bool binary_step = false;
+    while (begin < end)
+    {
+        const int lo = v[begin];
+        const int hi = v[end - 1];
+        if (x < lo || x > hi)
+            return -1; // x not found
+
+        int mid;
+        if (binary_step || lo == hi)
+            mid = (begin + end) / 2;
+        else // the values may be far apart, so use long long
+            mid = begin + (long long)(end - 1 - begin) * ((long long)x - lo)
+                          / ((long long)hi - lo);
+
+        const int old_size = end - begin;
+        if (v[mid] == x)
+        { // found x!
+            return mid;
+        }
+        else if (x < v[mid])
+        {
+            end = mid;
+        }
+        else // x > v[mid]
+        {
+            begin = mid + 1;
+        }
+        binary_step = !binary_step && end - begin > old_size / 2;
+    }
+    return -1; // x not found
+} // interpolation_search
+
+// Pre-condition:
+//    v is in ascending sorted order
+// Post-condition:
+//    returns an index i such that v[i] == x; if x is not in v, -1 is returned
+//
+// Checks v[0], v[1], v[3], v[7], v[15], ... until it finds a value >= x, and
+// then does a binary search of the part since the previous check. If x is at
+// position i this takes about 2 * log2(i) steps, no matter how big v is, so
+// it's faster than binary search when x is usually near the front. It would
+// work the same way on a sequence whose end isn't known (e.g. a very big
+// file), since it never needs n until it has gone past x.
+int exponential_search(int x, const vector<int> &v)
+{
+    const long n = v.size();
+    long bound = 1;
+    while (bound <= n && v[bound - 1] < x)
+    {
+        bound *= 2;
+    }
+    // v[bound / 2 - 1] < x (if bound > 1), and v[bound - 1] >= x (if
+    // bound <= n), so x can only be in v[bound / 2] to v[bound - 1]
+    return binary_search_loop(x, v, bound / 2, min(bound, n));
+}
+
+enum class Search_method
+{
+    binary,
+    interpolation,
+    exponential
+};
+
+// Returns the search method that's likely fastest for searching v, based on a
+// sample of v, and an optional sample of the values that will be searched for.
+//
+// - If most of the sampled queries are near the front of v, exponential search
+//   is chosen.
+// - Otherwise, if the sampled values of v are spread out evenly, i.e. the
+//   position of each value is close to where interpolation would guess it is,
+//   interpolation search is chosen.
+// - Otherwise, binary search is chosen.
+Search_method choose_search_method(const vector<int> &v,
+                                   const vector<int> &queries = {})
+{
+    const int n = v.size();
+    if (n < 64)
+        return Search_method::binary; // too small to matter
+
+    // a query is near the front if its position is in the first sqrt(n)
+    int near_front = 0;
+    for (int x : queries)
+    {
+        int pos = lower_bound(v.begin(), v.end(), x) - v.begin();
+        if (pos * (long long)pos < n)
+            near_front++;
+    }
+    if (!queries.empty() && near_front * 10 >= queries.size() * 9)
+        return Search_method::exponential;
+
+    // sample 64 evenly spaced positions, and check how far interpolation's
+    // guess for each sampled value is from its real position
+    const int samples = 64;
+    const long long lo = v[0];
+    const long long hi = v[n - 1];
+    if (lo == hi)
+        return Search_method::binary;
+    long long worst_error = 0;
+    for (int s = 0; s < samples; s++)
+    {
+        int i = (long long)s * (n - 1) / (samples - 1);
+        long long guess = (n - 1) * (v[i] - lo) / (hi - lo);
+        worst_error = max(worst_error, abs(guess - i));
+    }
+    if (worst_error <= n / samples)
+        return Search_method::interpolation;
+    return Search_method::binary;
+} // choose_search_method
+
+// searches for x in v using the given method
+int search(int x, const vector<int> &v, Search_method method)
+{
+    switch (method)
+    {
+    case Search_method::interpolation:
+        return interpolation_search(x, v);
+    case Search_method::exponential:
+        return exponential_search(x, v);
+    default:
+        return binary_search_loop(x, v);
+    }
+}
+
 void test_binary_search_loop()
 {
     cout << "calling test_binary_search_loop() ...\n";
@@ -137,8 +365,273 @@ void test_binary_search_rec()
     cout << "... test_binary_search_rec() done: all tests passed\n";
 }
 
-int main()
+void test_binary_search_batch()
+{
+    cout << "calling test_binary_search_batch() ...\n";
+    for (int n : {0, 1, 2, 3, 17, 100, 1000})
+    {
+        // lots of duplicates, so that which copy is found matters
+        vector<int> v;
+        for (int i = 0; i < n; i++)
+        {
+            v.push_back(i / 3);
+        }
+
+        // enough queries for several batches, plus a partial one
+        vector<int> queries;
+        for (int q = -2; q < n / 3 + 2; q++)
+        {
+            queries.push_back(q);
+        }
+        for (int i = 0; i < 3 * search_batch_size + 5; i++)
+        {
+            queries.push_back(rand() % (n / 3 + 2));
+        }
+
+        vector<int> result = binary_search_batch(queries, v);
+        assert(result.size() == queries.size());
+        for (int i = 0; i < queries.size(); i++)
+        {
+            assert(result[i] == binary_search_loop(queries[i], v));
+        }
+    }
+    assert(binary_search_batch({}, {1, 2, 3}).empty());
+
+    cout << "... test_binary_search_batch() done: all tests passed\n";
+}
+
+void test_interpolation_exponential_search()
+{
+    cout << "calling test_interpolation_exponential_search() ...\n";
+    vector<vector<int>> tests = {{}, {1}, {1, 3}, {1, 1, 1}, {1, 3, 5}};
+
+    // evenly spread, unevenly spread, duplicates, and extreme values
+    vector<int> even;
+    vector<int> squares;
+    vector<int> dups;
+    for (int i = 0; i < 1000; i++)
+    {
+        even.push_back(10 * i - 5000);
+        squares.push_back(i * i);
+        dups.push_back(i / 10);
+    }
+    tests.push_back(even);
+    tests.push_back(squares);
+    tests.push_back(dups);
+    tests.push_back({-2147483647 - 1, -5, 0, 1, 2, 3, 2147483647});
+
+    for (const vector<int> &v : tests)
+    {
+        vector<int> queries = {-2147483647 - 1, 2147483647};
+        for (int x : v)
+        {
+            queries.push_back(x);
+            if (x < 2147483647)
+                queries.push_back(x + 1);
+            if (x > -2147483647 - 1)
+                queries.push_back(x - 1);
+        }
+        for (int x : queries)
+        {
+            bool found = binary_search_loop(x, v) >= 0;
+            for (Search_method m : {Search_method::interpolation,
+                                    Search_method::exponential})
+            {
+                int i = search(x, v, m);
+                assert(found ? i >= 0 && v[i] == x : i == -1);
+            }
+        }
+    }
+
+    assert(choose_search_method(even) == Search_method::interpolation);
+    assert(choose_search_method(squares) == Search_method::binary);
+    assert(choose_search_method(even, {-5000, -4990, -4980})
+           == Search_method::exponential);
+    assert(choose_search_method(even, {0, 4000}) ==
+           Search_method::interpolation);
+
+    cout << "... test_interpolation_exponential_search() done: "
+         << "all tests passed\n";
+}
+
+void test_eytzinger_index()
+{
+    cout << "calling test_eytzinger_index() ...\n";
+    for (int n = 0; n <= 100; n++)
+    {
+        // v = {1, 3, 5, ...}, so every even number is missing
+        vector<int> v;
+        for (int i = 0; i < n; i++)
+        {
+            v.push_back(2 * i + 1);
+        }
+        cmpt::Eytzinger_index index(v);
+        for (int x = -1; x <= 2 * n + 1; x++)
+        {
+            assert(index.find(x) == binary_search_loop(x, v));
+        }
+    }
+
+    // with duplicates the first copy is found
+    vector<int> v = {1, 2, 2, 2, 2, 3, 3, 9};
+    cmpt::Eytzinger_index index(v);
+    assert(index.find(2) == 1);
+    assert(index.find(3) == 5);
+    assert(index.find(9) == 7);
+    assert(index.find(4) == -1);
+
+    cout << "... test_eytzinger_index() done: all tests passed\n";
+}
+
+void test_s_tree()
 {
+    cout << "calling test_s_tree() ...\n";
+    // sizes around multiples of 16 and 17, so nodes are full, partly full,
+    // and the tree has 1, 2 and 3 levels
+    for (int n : {0, 1, 2, 15, 16, 17, 33, 100, 271, 272, 273, 300, 4913, 5000})
+    {
+        // v = {1, 3, 5, ...}, so every even number is missing
+        vector<int> v;
+        for (int i = 0; i < n; i++)
+        {
+            v.push_back(2 * i + 1);
+        }
+        cmpt::S_tree tree(v);
+        for (int x = -1; x <= 2 * n + 1; x++)
+        {
+            assert(tree.find(x) == binary_search_loop(x, v));
+            assert(tree.contains(x) == (x % 2 == 1 && x < 2 * n));
+        }
+    }
+
+    // with duplicates the first copy is found, and INT_MAX (which is also
+    // used for unused keys) is only found if it's in v
+    vector<int> v = {1, 2, 2, 2, 2, 3, 3, 9};
+    cmpt::S_tree tree(v);
+    assert(tree.find(2) == 1);
+    assert(tree.find(3) == 5);
+    assert(tree.find(9) == 7);
+    assert(tree.find(4) == -1);
+    assert(tree.find(2147483647) == -1);
+    v = {-2147483647 - 1, 0, 2147483647, 2147483647};
+    cmpt::S_tree tree2(v);
+    assert(tree2.find(-2147483647 - 1) == 0);
+    assert(tree2.find(2147483647) == 2);
+
+    cout << "... test_s_tree() done: all tests passed\n";
+}
+
+// Returns a sorted vector of n different ints that are spread out, so that
+// searching for random ints finds some of them and misses others.
+vector<int> sorted_vector(int n)
+{
+    vector<int> v(n);
+    for (int i = 0; i < n; i++)
+    {
+        v[i] = 2 * i + 1;
+    }
+    return v;
+}
+
+// Times each search on sorted vectors of sizes 1024, 4096, ... up to max_n,
+// and prints a table of the results. Each repetition does the same random
+// searches, about half of which find their value. The values of v are spread
+// out evenly, which is the best case for interpolation search. The "front"
+// searches are for values in the first 128 positions of v, which is the best
+// case for exponential search. The Elements/s column is the number of
+// searches per second.
+void do_search_bench(int max_n)
+{
+    const int num_queries = 1 << 20;
+    cmpt::Bench bench(5, 1);
+    for (long n : cmpt::sweep(1024, max_n, 4))
+    {
+        vector<int> v = sorted_vector(n);
+        vector<int> queries(num_queries);
+        for (int &q : queries)
+        {
+            q = rand() % (2 * n + 1);
+        }
+        long kb = n * sizeof(int) / 1024;
+        string size = kb < 1024 ? " (" + to_string(kb) + " KB)"
+                                : " (" + to_string(kb / 1024) + " MB)";
+        long found = 0; // used so the searches can't be optimized away
+
+        bench.run("binary_search_loop" + size, num_queries, []() {},
+                  [&]()
+                  {
+                      for (int q : queries)
+                          found += binary_search_loop(q, v) >= 0;
+                  });
+
+        bench.run("binary_search_batch" + size, num_queries, []() {},
+                  [&]()
+                  {
+                      for (int i : binary_search_batch(queries, v))
+                          found += i >= 0;
+                  });
+
+        bench.run("interpolation" + size, num_queries, []() {},
+                  [&]()
+                  {
+                      for (int q : queries)
+                          found += interpolation_search(q, v) >= 0;
+                  });
+
+        // searches for values near the front of v
+        vector<int> front_queries(num_queries);
+        for (int &q : front_queries)
+        {
+            q = rand() % 256;
+        }
+        bench.run("front: binary" + size, num_queries, []() {},
+                  [&]()
+                  {
+                      for (int q : front_queries)
+                          found += binary_search_loop(q, v) >= 0;
+                  });
+        bench.run("front: exponential" + size, num_queries, []() {},
+                  [&]()
+                  {
+                      for (int q : front_queries)
+                          found += exponential_search(q, v) >= 0;
+                  });
+
+        cmpt::Eytzinger_index eytzinger(v);
+        bench.run("Eytzinger_index" + size, num_queries, []() {},
+                  [&]()
+                  {
+                      for (int q : queries)
+                          found += eytzinger.find(q) >= 0;
+                  });
+
+        cmpt::S_tree s_tree(v);
+        bench.run("S_tree" + size, num_queries, []() {},
+                  [&]()
+                  {
+                      for (int q : queries)
+                          found += s_tree.find(q) >= 0;
+                  });
+
+        if (found == 0)
+            cout << "no values found\n";
+    }
+    bench.print_table(cout);
+} // do_search_bench
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 2 && string(argv[1]) == "--bench")
+    {
+        int max_n = argc >= 3 ? atoi(argv[2]) : 1 << 26;
+        do_search_bench(max_n);
+        return 0;
+    }
+
     test_binary_search_loop();
     test_binary_search_rec();
+    test_binary_search_batch();
+    test_interpolation_exponential_search();
+    test_eytzinger_index();
+    test_s_tree();
 }
@@ -0,0 +1,529 @@
+// cmpt_algorithm.h
+
+// By defining CMPT_ALGORITHM_H, we avoid including this file more than once:
+// if CMPT_ALGORITHM_H is already defined, then the code is *not* included.
+#ifndef CMPT_ALGORITHM_H
+#define CMPT_ALGORITHM_H
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cmpt {
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Generic versions of the sorting and searching functions from lectures. The
+// lecture programs each have their own copy of insertion sort, mergesort and
+// binary search for int, string, or char. These templates work for any type,
+// and any random access iterators (e.g. vector<T>::iterator,
+// string::iterator, or a plain pointer), e.g.:
+//
+//     #include "cmpt_algorithm.h"
+//
+//     vector<string> words = {"up", "down", "all", "around"};
+//     cmpt::mergesort(words.begin(), words.end());
+//     // words is now {"all", "around", "down", "up"}
+//
+//     string s = "apple";
+//     cmpt::insertion_sort(s.begin(), s.end());
+//     // s is now "aelpp"
+//
+//     vector<int> v = {5, 2, 8};
+//     cmpt::mergesort(v.begin(), v.end(), greater<int>());
+//     // v is now {8, 5, 2}
+//
+//     int i = cmpt::generic_binary_search(v.begin(), v.end(), 5,
+//                                         greater<int>());
+//     // i is 1
+//
+// The optional last argument, comp, is the comparison to sort by: comp(a, b)
+// returns true when a should come before b. The default is <.
+//
+// The names generic_sort, generic_binary_search and generic_is_sorted are
+// different from std::sort, std::binary_search and std::is_sorted on purpose:
+// this file, like the rest of the cmpt files, says using namespace std, and
+// with the same names a call like sort(v.begin(), v.end()) anywhere in
+// namespace cmpt couldn't tell which one was meant.
+//
+// cmpt::generic_sort picks the fastest sort it can for the type being sorted.
+// For integer types sorted with the default <, the order of equal values
+// doesn't matter (they can't be told apart), so it uses counting sort for
+// 1-byte integers (e.g. char) and radix sort for other integers. For all other
+// types it uses mergesort. The choice is made when the program is compiled,
+// using if constexpr, and so costs nothing when the program runs.
+//
+// All the sorts are stable, and each one gives the same result as the
+// lecture version of the same algorithm.
+//
+// top_k returns the k smallest values in a range, in sorted order. It only
+// needs to see each value once, so it works on input streams too, e.g. this
+// prints the 10 alphabetically first words read from cin, without keeping
+// all the words in memory:
+//
+//     vector<string> first10 = cmpt::top_k(istream_iterator<string>(cin),
+//                                          istream_iterator<string>(), 10);
+//     for (const string &w : first10) cout << w << "\n";
+//
+// argsort sorts the positions of the elements instead of the elements
+// themselves, and apply_permutation then moves each element once to where it
+// belongs. That's faster than sorting big elements (e.g. long strings, or
+// structs with many fields) directly, since sorting moves each element many
+// times:
+//
+//     vector<Person> people = ...;
+//     vector<int> p = cmpt::argsort(people.begin(), people.end());
+//     // people[p[0]] is the first person in sorted order
+//     cmpt::apply_permutation(people.begin(), p);
+//     // people is now sorted
+//
+// parallel_merge merges two sorted ranges using several threads, e.g.:
+//
+//     vector<string> a = {"ant", "cat", "dog"};
+//     vector<string> b = {"bee", "cow"};
+//     vector<string> c = cmpt::parallel_merge(a, b, 4);
+//     // c is {"ant", "bee", "cat", "cow", "dog"}
+//
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace std;
+
+// Sorts first to last - 1 with insertion sort.
+template <typename RandomIt, typename Compare = less<>>
+void insertion_sort(RandomIt first, RandomIt last, Compare comp = Compare())
+{
+    if (first == last)
+        return;
+    for (RandomIt i = first + 1; i != last; ++i)
+    {
+        auto key = std::move(*i);
+        RandomIt j = i;
+        while (j != first && comp(key, *(j - 1)))
+        {
+            *j = std::move(*(j - 1));
+            --j;
+        }
+        *j = std::move(key);
+    }
+}
+
+// Sorts first to last - 1 with binary insertion sort: each insertion point is
+// found by binary search, and the elements after it are moved up as a block.
+template <typename RandomIt, typename Compare = less<>>
+void binary_insertion_sort(RandomIt first, RandomIt last,
+                           Compare comp = Compare())
+{
+    if (first == last)
+        return;
+    for (RandomIt i = first + 1; i != last; ++i)
+    {
+        RandomIt pos = std::upper_bound(first, i, *i, comp);
+        std::rotate(pos, i, i + 1);
+    }
+}
+
+// Sub-ranges smaller than this are sorted by insertion sort in mergesort.
+const int mergesort_insertion_cutoff = 16;
+
+// Pre-condition:
+//    first to mid - 1, and mid to last - 1, are both sorted
+// Post-condition:
+//    first to last - 1 is sorted
+//
+// The left half is moved into buf, and then merged with the right half back
+// into place. Equal elements are taken from the left half first.
+template <typename RandomIt, typename T, typename Compare>
+void merge_with_buffer(RandomIt first, RandomIt mid, RandomIt last,
+                       vector<T> &buf, Compare comp)
+{
+    buf.clear();
+    std::move(first, mid, back_inserter(buf));
+    auto a = buf.begin();
+    RandomIt b = mid;
+    RandomIt out = first;
+    while (a != buf.end() && b != last)
+    {
+        if (comp(*b, *a))
+            *out++ = std::move(*b++);
+        else
+            *out++ = std::move(*a++);
+    }
+    std::move(a, buf.end(), out);
+    // anything left in the right half is already in place
+}
+
+template <typename RandomIt, typename T, typename Compare>
+void mergesort_with_buffer(RandomIt first, RandomIt last, vector<T> &buf,
+                           Compare comp)
+{
+    if (last - first < mergesort_insertion_cutoff)
+    {
+        cmpt::insertion_sort(first, last, comp);
+        return;
+    }
+    RandomIt mid = first + (last - first) / 2;
+    cmpt::mergesort_with_buffer(first, mid, buf, comp);
+    cmpt::mergesort_with_buffer(mid, last, buf, comp);
+
+    // if the halves are already in order there's nothing to merge
+    if (comp(*mid, *(mid - 1)))
+        cmpt::merge_with_buffer(first, mid, last, buf, comp);
+}
+
+// Sorts first to last - 1 with mergesort. Uses one buffer, half the size of
+// the range, for the whole sort.
+template <typename RandomIt, typename Compare = less<>>
+void mergesort(RandomIt first, RandomIt last, Compare comp = Compare())
+{
+    using T = typename iterator_traits<RandomIt>::value_type;
+    vector<T> buf;
+    buf.reserve((last - first) / 2 + 1);
+    cmpt::mergesort_with_buffer(first, last, buf, comp);
+}
+
+// Counting sort for 1-byte integer types: counts how many times each of the
+// 256 possible values appears, and then writes them out in order.
+template <typename RandomIt>
+void counting_sort(RandomIt first, RandomIt last)
+{
+    using T = typename iterator_traits<RandomIt>::value_type;
+    static_assert(is_integral<T>::value && sizeof(T) == 1,
+                  "counting_sort only works for 1-byte integers");
+    long count[256] = {};
+    for (RandomIt i = first; i != last; ++i)
+    {
+        count[static_cast<unsigned char>(*i)]++;
+    }
+
+    // for signed types, the negative values (128 to 255 as unsigned) go first
+    const int start = is_signed<T>::value ? 128 : 0;
+    RandomIt out = first;
+    for (int k = 0; k < 256; k++)
+    {
+        unsigned char u = static_cast<unsigned char>((start + k) % 256);
+        out = std::fill_n(out, count[u], static_cast<T>(u));
+    }
+}
+
+// LSD radix sort for integer types, one byte at a time. The sign bit is
+// flipped so that negative values sort first.
+template <typename RandomIt>
+void radix_sort(RandomIt first, RandomIt last)
+{
+    using T = typename iterator_traits<RandomIt>::value_type;
+    using U = typename make_unsigned<T>::type;
+    static_assert(is_integral<T>::value, "radix_sort only works for integers");
+
+    const U flip = is_signed<T>::value ? U(U(1) << (8 * sizeof(T) - 1)) : U(0);
+    vector<T> src(first, last);
+    vector<T> dst(src.size());
+    for (int pass = 0; pass < int(sizeof(T)); pass++)
+    {
+        // returns byte number pass of x, with the sign bit flipped
+        auto digit = [flip, pass](T x)
+        { return (U(x) ^ flip) >> (8 * pass) & 0xFF; };
+
+        long count[257] = {};
+        for (T x : src)
+        {
+            count[digit(x) + 1]++;
+        }
+
+        // if every value has the same byte this pass wouldn't change anything
+        if (src.empty() || count[digit(src[0]) + 1] == long(src.size()))
+            continue;
+
+        for (int b = 0; b < 256; b++)
+        {
+            count[b + 1] += count[b];
+        }
+        for (T x : src)
+        {
+            dst[count[digit(x)]++] = x;
+        }
+        src.swap(dst);
+    }
+    std::copy(src.begin(), src.end(), first);
+}
+
+// Sorts first to last - 1, choosing the algorithm at compile time: see the
+// comment at the top of the file.
+template <typename RandomIt, typename Compare = less<>>
+void generic_sort(RandomIt first, RandomIt last, Compare comp = Compare())
+{
+    using T = typename iterator_traits<RandomIt>::value_type;
+    constexpr bool default_order = is_same<Compare, less<>>::value ||
+                                   is_same<Compare, less<T>>::value;
+    if constexpr (is_integral<T>::value && !is_same<T, bool>::value &&
+                  default_order)
+    {
+        if constexpr (sizeof(T) == 1)
+            cmpt::counting_sort(first, last);
+        else
+            cmpt::radix_sort(first, last);
+    }
+    else
+    {
+        cmpt::mergesort(first, last, comp);
+    }
+}
+
+// Returns the number of threads to use by default: one per core.
+inline int default_threads()
+{
+    return max(1u, thread::hardware_concurrency());
+}
+
+// Pre-condition:
+//    a[0] to a[a_n - 1] and b[0] to b[b_n - 1] are sorted by comp, and
+//    0 <= diag <= a_n + b_n
+// Post-condition:
+//    returns how many elements of a are among the first diag elements of the
+//    merge of a and b
+//
+// Imagine a grid with a along the top and b down the side: merging is a path
+// from the top-left corner to the bottom-right, going right when an element of
+// a is taken and down when an element of b is taken. This finds where that
+// path (the merge path) crosses the diagonal of cells at distance diag from
+// the corner, using binary search along the diagonal.
+template <typename RandomIt1, typename RandomIt2, typename Compare>
+int merge_path_split(RandomIt1 a, int a_n, RandomIt2 b, int b_n, int diag,
+                     Compare comp)
+{
+    int lo = max(0, diag - b_n);
+    int hi = min(diag, a_n);
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        // on ties elements of a go first, so a[mid] is taken after b[j] only
+        // if b[j] < a[mid]
+        if (comp(b[diag - mid - 1], a[mid]))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+// Merges first1 to last1 - 1 and first2 to last2 - 1, which are both sorted by
+// comp, into out, using up to threads threads. Equal elements are taken from
+// the first range first, like std::merge.
+//
+// The output is divided into threads equal-size pieces, and merge_path_split
+// finds which part of each input goes into each piece. The pieces are then
+// merged at the same time, each by its own thread, and each thread does the
+// same amount of work no matter how the values are distributed.
+template <typename RandomIt1, typename RandomIt2, typename OutIt,
+          typename Compare = less<>>
+void parallel_merge(RandomIt1 first1, RandomIt1 last1,
+                    RandomIt2 first2, RandomIt2 last2,
+                    OutIt out, int threads, Compare comp = Compare())
+{
+    const int a_n = last1 - first1;
+    const int b_n = last2 - first2;
+    const int n = a_n + b_n;
+
+    // small merges aren't worth starting threads for
+    const int min_per_thread = 1 << 14;
+    threads = max(1, min(threads, n / min_per_thread));
+    if (threads == 1)
+    {
+        std::merge(first1, last1, first2, last2, out, comp);
+        return;
+    }
+
+    vector<int> a_split(threads + 1);
+    for (int p = 0; p <= threads; p++)
+    {
+        int diag = long(n) * p / threads;
+        a_split[p] = cmpt::merge_path_split(first1, a_n, first2, b_n, diag,
+                                            comp);
+    }
+
+    vector<thread> workers;
+    for (int p = 0; p < threads; p++)
+    {
+        int diag = long(n) * p / threads;
+        int next_diag = long(n) * (p + 1) / threads;
+        int a_begin = a_split[p];
+        int a_end = a_split[p + 1];
+        int b_begin = diag - a_begin;
+        int b_end = next_diag - a_end;
+        workers.push_back(thread([=]()
+            { std::merge(first1 + a_begin, first1 + a_end,
+                         first2 + b_begin, first2 + b_end,
+                         out + diag, comp); }));
+    }
+    for (thread &t : workers)
+    {
+        t.join();
+    }
+} // parallel_merge
+
+// Returns the merge of a and b, which are both sorted by comp, computed with
+// up to threads threads.
+template <typename T, typename Compare = less<>>
+vector<T> parallel_merge(const vector<T> &a, const vector<T> &b,
+                         int threads = default_threads(),
+                         Compare comp = Compare())
+{
+    vector<T> result(a.size() + b.size());
+    cmpt::parallel_merge(a.begin(), a.end(), b.begin(), b.end(),
+                         result.begin(), threads, comp);
+    return result;
+}
+
+// Pre-condition:
+//    first to last - 1 is sorted by comp
+// Post-condition:
+//    returns an index i such that first[i] is equivalent to x (neither
+//    comp(first[i], x) nor comp(x, first[i])); if x is not found, -1 is
+//    returned
+//
+// The middle element is checked first, like in the lecture version, so the
+// same index is returned when there is more than one copy of x.
+template <typename RandomIt, typename T, typename Compare = less<>>
+int generic_binary_search(RandomIt first, RandomIt last, const T &x,
+                          Compare comp = Compare())
+{
+    int begin = 0;
+    int end = last - first;
+    while (begin < end)
+    {
+        int mid = (begin + end) / 2;
+        if (comp(x, first[mid]))
+            end = mid;
+        else if (comp(first[mid], x))
+            begin = mid + 1;
+        else
+            return mid; // found x!
+    }
+    return -1; // x not found
+}
+
+// Returns the smallest i such that first[i] == x, or -1 if there isn't one.
+template <typename RandomIt, typename T>
+int linear_search(RandomIt first, RandomIt last, const T &x)
+{
+    for (RandomIt i = first; i != last; ++i)
+    {
+        if (*i == x)
+            return i - first;
+    }
+    return -1;
+}
+
+// Returns the k smallest values (according to comp) of first to last - 1, in
+// ascending order; if there are fewer than k values, all of them are returned.
+// first and last can be input iterators, which are read only once.
+//
+// A max-heap holds the k smallest values seen so far, so its top is the
+// biggest of them. Each new value smaller than the top replaces it. This
+// takes O(n log k) time, and memory for only k values.
+template <typename InputIt, typename Compare = less<>>
+vector<typename iterator_traits<InputIt>::value_type>
+top_k(InputIt first, InputIt last, int k, Compare comp = Compare())
+{
+    using T = typename iterator_traits<InputIt>::value_type;
+    vector<T> result;
+    if (k <= 0)
+        return result;
+
+    priority_queue<T, vector<T>, Compare> heap(comp);
+    for (; first != last; ++first)
+    {
+        if (heap.size() < k)
+        {
+            heap.push(*first);
+        }
+        else if (comp(*first, heap.top()))
+        {
+            heap.pop();
+            heap.push(*first);
+        }
+    }
+
+    // the heap gives the values biggest first
+    result.resize(heap.size());
+    for (int i = result.size() - 1; i >= 0; i--)
+    {
+        result[i] = heap.top();
+        heap.pop();
+    }
+    return result;
+}
+
+// Returns the permutation p that sorts first to last - 1 by comp, i.e.
+// first[p[0]] is the smallest element, first[p[1]] the next smallest, and so
+// on. The range isn't changed: only the ints in p are moved while sorting,
+// which is much cheaper than moving big elements. Equal elements keep their
+// order.
+template <typename RandomIt, typename Compare = less<>>
+vector<int> argsort(RandomIt first, RandomIt last, Compare comp = Compare())
+{
+    vector<int> p(last - first);
+    for (int i = 0; i < p.size(); i++)
+    {
+        p[i] = i;
+    }
+    cmpt::mergesort(p.begin(), p.end(),
+                    [&](int a, int b) { return comp(first[a], first[b]); });
+    return p;
+}
+
+// Pre-condition:
+//    p is a permutation of 0, 1, ..., p.size() - 1, e.g. from argsort, and
+//    first to first + p.size() - 1 is a valid range
+// Post-condition:
+//    first[i] is the element that was at first[p[i]]
+//
+// A permutation is made of cycles: first[i] gets first[p[i]], which gets
+// first[p[p[i]]], and so on until the cycle gets back to i. Each cycle is done
+// by saving first[i], moving every other element of the cycle once, and then
+// putting the saved element at the end of the cycle. So every element is moved
+// exactly once, plus one extra move per cycle.
+template <typename RandomIt>
+void apply_permutation(RandomIt first, const vector<int> &p)
+{
+    using T = typename iterator_traits<RandomIt>::value_type;
+    vector<bool> done(p.size(), false);
+    for (int i = 0; i < p.size(); i++)
+    {
+        if (done[i] || p[i] == i)
+            continue;
+
+        T saved = std::move(first[i]);
+        int j = i;
+        while (p[j] != i)
+        {
+            first[j] = std::move(first[p[j]]);
+            done[j] = true;
+            j = p[j];
+        }
+        first[j] = std::move(saved);
+        done[j] = true;
+    }
+}
+
+// Returns true if first to last - 1 is sorted by comp.
+template <typename RandomIt, typename Compare = less<>>
+bool generic_is_sorted(RandomIt first, RandomIt last,
+                       Compare comp = Compare())
+{
+    for (RandomIt i = first; i != last && i + 1 != last; ++i)
+    {
+        if (comp(*(i + 1), *i))
+            return false;
+    }
+    return true;
+}
+
+} // namespace cmpt
+
+#endif
@@ -0,0 +1,180 @@
+// cmpt_dictionary.h
+
+// By defining CMPT_DICTIONARY_H, we avoid including this file more than once:
+// if CMPT_DICTIONARY_H is already defined, then the code is *not* included.
+#ifndef CMPT_DICTIONARY_H
+#define CMPT_DICTIONARY_H
+
+#include "cmpt_error.h"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// open, fstat, mmap, etc. are POSIX functions, so this file works on Linux and
+// macOS but not Windows
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cmpt {
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Mapped_dictionary looks up words in a sorted word list file, such as
+// ospd_sorted.txt, without reading the words into strings, e.g.:
+//
+//     #include "cmpt_dictionary.h"
+//
+//     cmpt::Mapped_dictionary dict("ospd_sorted.txt");
+//     bool a = dict.contains("cat");   // true
+//     bool b = dict.contains("cta");   // false
+//     int i = dict.find("cat");        // i is the line number of "cat",
+//                                      // counting from 0, so dict[i] == "cat"
+//
+// Reading a file into a vector<string> with cin >> w copies every word into its
+// own string, and that takes time and memory: a string is 32 bytes even for a
+// short word. Instead, the file is memory-mapped with mmap, which makes its
+// bytes look like one big array of chars. Nothing is actually read from the
+// file until it's used, and then the operating system reads it a page at a
+// time (usually 4096 bytes), and keeps it in its file cache.
+//
+// The constructor makes one pass over the bytes to find where each line
+// starts, and saves that in a table with one 4-byte int per word. Word i is
+// then a string_view of the bytes from offset[i] up to the '\n' before
+// offset[i + 1]. A string_view is just a pointer and a length, so getting a
+// word copies nothing, and find does binary search directly on the mapped
+// bytes. The memory used is about the size of the file plus 4 bytes per word.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace std;
+
+class Mapped_dictionary {
+private:
+    const char *data;       // the mapped file, or nullptr if it's empty
+    size_t num_bytes;
+    vector<uint32_t> offset; // offset[i] is where word i starts; the last
+                             // entry is one past the end of the last word's
+                             // line, i.e. where the next word would start
+
+public:
+    // Pre-condition:
+    //    filename is a file with one word per line, in ascending sorted order
+    //    (as sorted by <), and is smaller than 4 GB
+    // Post-condition:
+    //    the file is mapped into memory, and its lines are indexed
+    Mapped_dictionary(const string &filename);
+
+    // The mapping can only be unmapped once, so a Mapped_dictionary can't be
+    // copied.
+    Mapped_dictionary(const Mapped_dictionary &) = delete;
+    Mapped_dictionary &operator=(const Mapped_dictionary &) = delete;
+
+    ~Mapped_dictionary();
+
+    // number of words
+    int size() const { return offset.size() - 1; }
+
+    // returns word i, for 0 <= i < size(); the string_view is valid as long as
+    // this Mapped_dictionary exists
+    string_view operator[](int i) const;
+
+    // returns the smallest i such that (*this)[i] == w, or -1 if w isn't in
+    // the dictionary
+    int find(string_view w) const;
+
+    bool contains(string_view w) const { return find(w) != -1; }
+}; // class Mapped_dictionary
+
+//
+// implementation
+//
+
+inline Mapped_dictionary::Mapped_dictionary(const string &filename)
+: data(nullptr), num_bytes(0)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) cmpt::error("can't open " + filename);
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        cmpt::error("can't get the size of " + filename);
+    }
+    num_bytes = info.st_size;
+    if (num_bytes >= UINT32_MAX) {
+        close(fd);
+        cmpt::error(filename + " is too big: it must be smaller than 4 GB");
+    }
+
+    // mmap can't map 0 bytes, so an empty file is left unmapped
+    if (num_bytes > 0) {
+        void *p = mmap(nullptr, num_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            cmpt::error("can't map " + filename + " into memory");
+        }
+        data = static_cast<const char *>(p);
+    }
+    // the mapping stays valid after the file is closed
+    close(fd);
+
+    // memchr is much faster than checking one char at a time, since it can
+    // check many chars at once
+    size_t start = 0;
+    while (start < num_bytes) {
+        offset.push_back(start);
+        const void *newline = memchr(data + start, '\n', num_bytes - start);
+        if (newline == nullptr) {
+            // the last line has no '\n', so pretend it does
+            start = num_bytes + 1;
+        } else {
+            start = static_cast<const char *>(newline) - data + 1;
+        }
+    }
+    offset.push_back(start);
+
+    // binary search jumps all over the file, so tell the operating system
+    // not to bother reading ahead of each page that's used
+    if (data != nullptr) {
+        madvise(const_cast<char *>(data), num_bytes, MADV_RANDOM);
+    }
+}
+
+inline Mapped_dictionary::~Mapped_dictionary() {
+    if (data != nullptr) {
+        munmap(const_cast<char *>(data), num_bytes);
+    }
+}
+
+inline string_view Mapped_dictionary::operator[](int i) const {
+    const char *begin = data + offset[i];
+    size_t len = offset[i + 1] - offset[i] - 1; // -1 for the '\n'
+
+    // files saved on Windows end lines with "\r\n"
+    if (len > 0 && begin[len - 1] == '\r') len--;
+    return string_view(begin, len);
+}
+
+inline int Mapped_dictionary::find(string_view w) const {
+    // binary search for the first word >= w
+    int begin = 0;
+    int end = size();
+    while (begin < end) {
+        int mid = (begin + end) / 2;
+        if ((*this)[mid] < w) {
+            begin = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+    if (begin < size() && (*this)[begin] == w) return begin;
+    return -1;
+}
+
+} // namespace cmpt
+
+#endif
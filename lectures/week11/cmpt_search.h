@@ -0,0 +1,244 @@
+// cmpt_search.h
+
+// By defining CMPT_SEARCH_H, we avoid including this file more than once: if
+// CMPT_SEARCH_H is already defined, then the code is *not* included.
+#ifndef CMPT_SEARCH_H
+#define CMPT_SEARCH_H
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace cmpt {
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// Faster ways to search a sorted vector<int> that doesn't change, e.g.:
+//
+//     #include "cmpt_search.h"
+//
+//     vector<int> v = {2, 3, 5, 7, 11, 13};
+//     cmpt::Eytzinger_index index(v);
+//     int i = index.find(7);   // i is 3, since v[3] == 7
+//     int j = index.find(8);   // j is -1, since 8 is not in v
+//
+// find returns the same thing binary search on v would: an index i with
+// v[i] == x, or -1 if x isn't in v. If x appears more than once, it returns
+// the first i with v[i] == x.
+//
+// Binary search is slow on big vectors because of the cache. The first few
+// values it checks (v[n/2], v[n/4], v[3n/4], ...) are far apart in memory, so
+// each one is usually a cache miss, and the CPU waits for it before it knows
+// which value to check next.
+//
+// Eytzinger_index stores the values in a different order: the order binary
+// search would visit them in, level by level, like a heap. The root (v[n/2])
+// is at position 1, its two children (v[n/4] and v[3n/4]) are at positions 2
+// and 3, and in general the children of position k are at 2k and 2k + 1. So
+// the first few levels, which every search uses, are next to each other at
+// the start, and stay in the cache.
+//
+// Even better, the 16 descendants of position k that are 4 levels down are at
+// 16k to 16k + 15, which is a single 64-byte cache line. So each search step
+// asks the CPU to start loading (prefetch) the cache line it will need 4 steps
+// later, and by the time it's needed it's usually there.
+//
+// S_tree (a static B-tree) goes further: each node of its tree holds 16
+// values, which fill exactly one cache line, and has 17 children. So a search
+// reads about log16(n) cache lines, e.g. 6 instead of about 24 for 16 million
+// values. The 16 values of a node are compared with x all at once using AVX2
+// instructions (if the CPU has them), and the number of values less than x
+// says which child to go to next. It's used the same way as Eytzinger_index,
+// and also has contains(x):
+//
+//     cmpt::S_tree tree(v);
+//     int i = tree.find(7);        // i is 3
+//     bool b = tree.contains(8);   // b is false
+//
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace std;
+
+class Eytzinger_index {
+private:
+    // 16 ints, aligned to the start of a cache line
+    struct alignas(64) Cache_line {
+        int values[16];
+    };
+
+    int n;
+    vector<Cache_line> storage; // holds the tree, as ints 0 to n
+    vector<int> position;       // position[k] is the index in v of tree()[k]
+
+    int *tree() { return storage.data()->values; }
+    const int *tree() const { return storage.data()->values; }
+
+    // puts v[i], v[i + 1], ... into the subtree at k; returns the next i
+    int build(const vector<int> &v, int i, int k);
+
+public:
+    // Pre-condition:
+    //    v is in ascending sorted order
+    Eytzinger_index(const vector<int> &v);
+
+    // returns an index i such that v[i] == x, or -1 if x isn't in v
+    int find(int x) const;
+
+    int size() const { return n; }
+}; // class Eytzinger_index
+
+//
+// implementation
+//
+
+inline int Eytzinger_index::build(const vector<int> &v, int i, int k) {
+    // an in-order walk of the tree visits the positions in the order of the
+    // values in v
+    if (k <= n) {
+        i = build(v, i, 2 * k);
+        tree()[k] = v[i];
+        position[k] = i;
+        i++;
+        i = build(v, i, 2 * k + 1);
+    }
+    return i;
+}
+
+inline Eytzinger_index::Eytzinger_index(const vector<int> &v)
+: n(v.size()), storage(n / 16 + 1), position(n + 1, -1)
+{
+    build(v, 0, 1);
+}
+
+inline int Eytzinger_index::find(int x) const {
+    const int *t = tree();
+    int k = 1;
+    while (k <= n) {
+        // the descendants 4 levels down only exist if 16k <= n; size_t so
+        // that 16k doesn't overflow for big n
+        const size_t ahead = 16 * size_t(k);
+        if (ahead <= size_t(n))
+            __builtin_prefetch(t + ahead);
+        k = 2 * k + (t[k] < x);
+    }
+
+    // k went right every time t[k] < x, and left at the first t[k] >= x on
+    // the way down; undoing the right turns after that last left turn gets
+    // back to it (or to 0 if there wasn't one, i.e. x is bigger than all)
+    k >>= __builtin_ffs(~k);
+    if (k == 0 || t[k] != x)
+        return -1;
+    return position[k];
+}
+
+// returns the number of values in keys[0] to keys[15] that are less than x
+inline int count_less16_scalar(const int *keys, int x) {
+    int count = 0;
+    for (int i = 0; i < 16; i++) {
+        count += keys[i] < x;
+    }
+    return count;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Same as count_less16_scalar, with two 8-int compares. keys must be aligned
+// to 32 bytes.
+__attribute__((target("avx2,popcnt")))
+inline int count_less16_avx2(const int *keys, int x) {
+    const __m256i key = _mm256_set1_epi32(x);
+    __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i *>(keys));
+    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i *>(keys + 8));
+    // x > keys[i] is the same as keys[i] < x
+    __m256i less_a = _mm256_cmpgt_epi32(key, a);
+    __m256i less_b = _mm256_cmpgt_epi32(key, b);
+    unsigned mask_a = _mm256_movemask_ps(_mm256_castsi256_ps(less_a));
+    unsigned mask_b = _mm256_movemask_ps(_mm256_castsi256_ps(less_b));
+    return _mm_popcnt_u32(mask_a | (mask_b << 8));
+}
+#endif
+
+class S_tree {
+private:
+    static const int B = 16; // values per node
+
+    struct alignas(64) Node {
+        int keys[B];      // in ascending order; unused keys are INT_MAX
+    };
+
+    int n;
+    int num_nodes;
+    vector<Node> nodes;
+    vector<int> position; // position[B * k + j] is the index in v of
+                          // nodes[k].keys[j], or n for unused keys
+    int (*count_less16)(const int *, int);
+
+    // returns the number of the j-th child of node k, for 0 <= j <= B
+    static int child(int k, int j) { return k * (B + 1) + j + 1; }
+
+    // puts v[i], v[i + 1], ... into the subtree at k; returns the next i
+    int build(const vector<int> &v, int i, int k);
+
+public:
+    // Pre-condition:
+    //    v is in ascending sorted order
+    S_tree(const vector<int> &v);
+
+    // returns an index i such that v[i] == x, or -1 if x isn't in v
+    int find(int x) const;
+
+    bool contains(int x) const { return find(x) != -1; }
+
+    int size() const { return n; }
+}; // class S_tree
+
+inline int S_tree::build(const vector<int> &v, int i, int k) {
+    // an in-order walk: the subtree left of each key, then the key
+    if (k < num_nodes) {
+        for (int j = 0; j < B; j++) {
+            i = build(v, i, child(k, j));
+            nodes[k].keys[j] = i < n ? v[i] : INT_MAX;
+            position[B * k + j] = min(i, n);
+            i++;
+        }
+        i = build(v, i, child(k, B));
+    }
+    return i;
+}
+
+inline S_tree::S_tree(const vector<int> &v)
+: n(v.size()), num_nodes((n + B - 1) / B), nodes(num_nodes),
+  position(B * num_nodes), count_less16(count_less16_scalar)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        count_less16 = count_less16_avx2;
+#endif
+    build(v, 0, 0);
+}
+
+inline int S_tree::find(int x) const {
+    // the last key >= x seen on the way down is the smallest key >= x, since
+    // each key found is in the subtree just to the left of the one before
+    int best = -1; // B * node + slot of that key
+    int k = 0;
+    while (k < num_nodes) {
+        int j = count_less16(nodes[k].keys, x);
+        if (j < B)
+            best = B * k + j;
+        k = child(k, j);
+    }
+
+    // a key equal to INT_MAX may be an unused key, with position n
+    if (best == -1 || position[best] == n
+        || nodes[best / B].keys[best % B] != x)
+        return -1;
+    return position[best];
+}
+
+} // namespace cmpt
+
+#endif
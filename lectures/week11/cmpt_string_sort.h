@@ -0,0 +1,207 @@
+// cmpt_string_sort.h
+
+// By defining CMPT_STRING_SORT_H, we avoid including this file more than once:
+// if CMPT_STRING_SORT_H is already defined, then the code is *not* included.
+#ifndef CMPT_STRING_SORT_H
+#define CMPT_STRING_SORT_H
+
+#include "cmpt_algorithm.h"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cmpt {
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// msd_radix_sort sorts a vector<string> into the same order as a comparison
+// sort that uses <, e.g.:
+//
+//     #include "cmpt_string_sort.h"
+//
+//     vector<string> words = {"cat", "car", "ant", "cart"};
+//     cmpt::msd_radix_sort(words);
+//     // words is now {"ant", "car", "cart", "cat"}
+//
+// It never compares two whole strings. Instead, it looks at the first character
+// of every string and puts the strings into buckets by that character, and
+// then sorts each bucket by the second character, and so on. Words in a
+// dictionary share a lot of prefixes, and comparison sorts re-read those
+// prefixes on every comparison, while radix sort reads each character about
+// once.
+//
+// The sort is stable, i.e. equal strings stay in the same order they started
+// in.
+//
+// prefix_key_sort is a mergesort that speeds up comparisons instead. Comparing
+// two strings means following a pointer to each string's characters, which
+// are usually not in the cache. So before sorting, the first 8 characters of
+// each string are packed into a 64-bit integer key that is stored right next
+// to the pointer to the string. Most comparisons are decided by comparing the
+// keys, and only when the keys are equal are the strings themselves compared.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace std;
+
+// Buckets with fewer strings than this are sorted by insertion sort, which is
+// faster than counting 257 buckets for just a few strings.
+const int msd_insertion_cutoff = 32;
+
+// Stable insertion sort of a[0] to a[n - 1], which all have the same first
+// depth characters, so only the characters after that are compared.
+inline void msd_insertion_sort(string **a, int n, int depth)
+{
+    for (int i = 1; i < n; i++)
+    {
+        string *key = a[i];
+        int j = i - 1;
+        while (j >= 0 && a[j]->compare(depth, string::npos,
+                                       *key, depth, string::npos) > 0)
+        {
+            a[j + 1] = a[j];
+            j--;
+        }
+        a[j + 1] = key;
+    }
+}
+
+// returns the bucket of s at position depth: 0 if s has no character there
+// (so shorter strings come first), and otherwise 1 + the character as an
+// unsigned char (which is how < compares chars in strings)
+inline int msd_bucket(const string &s, int depth)
+{
+    if (depth >= s.size())
+        return 0;
+    return 1 + static_cast<unsigned char>(s[depth]);
+}
+
+// Sorts a[0] to a[n - 1] by the characters from depth onwards; all the strings
+// have the same first depth characters. aux has room for n pointers.
+inline void msd_radix_sort(string **a, string **aux, int n, int depth)
+{
+    if (n < msd_insertion_cutoff)
+    {
+        msd_insertion_sort(a, n, depth);
+        return;
+    }
+
+    // count the size of each bucket
+    const int buckets = 257;
+    int count[buckets + 1] = {};
+    for (int i = 0; i < n; i++)
+    {
+        count[msd_bucket(*a[i], depth) + 1]++;
+    }
+
+    // count[b] becomes the index where the first string of bucket b goes
+    for (int b = 0; b < buckets; b++)
+    {
+        count[b + 1] += count[b];
+    }
+
+    // stably distribute the strings into their buckets, then copy them back
+    for (int i = 0; i < n; i++)
+    {
+        aux[count[msd_bucket(*a[i], depth)]++] = a[i];
+    }
+    for (int i = 0; i < n; i++)
+    {
+        a[i] = aux[i];
+    }
+
+    // count[b] is now the end of bucket b; bucket 0 holds the strings that end
+    // at depth, and they are all equal, so only buckets 1 to 256 are sorted
+    for (int b = 1; b < buckets; b++)
+    {
+        int begin = count[b - 1];
+        int size = count[b] - begin;
+        if (size > 1)
+        {
+            msd_radix_sort(a + begin, aux + begin, size, depth + 1);
+        }
+    }
+} // msd_radix_sort
+
+// Sorts v into ascending order. Pointers to the strings are sorted, and then
+// each string is moved once into its final place.
+inline void msd_radix_sort(vector<string> &v)
+{
+    const int n = v.size();
+    vector<string *> p(n);
+    vector<string *> aux(n);
+    for (int i = 0; i < n; i++)
+    {
+        p[i] = &v[i];
+    }
+    msd_radix_sort(p.data(), aux.data(), n, 0);
+
+    vector<string> sorted;
+    sorted.reserve(n);
+    for (int i = 0; i < n; i++)
+    {
+        sorted.push_back(move(*p[i]));
+    }
+    v.swap(sorted);
+}
+
+// A string together with its first 8 characters packed into an integer.
+struct Keyed_string
+{
+    uint64_t key;
+    string *s;
+};
+
+// Returns the first 8 characters of s packed into a 64-bit integer, with the
+// first character in the most significant byte (i.e. big-endian order). Short
+// strings are padded with 0s. Comparing two keys as integers gives the same
+// result as comparing the first 8 characters of the strings.
+inline uint64_t prefix_key(const string &s)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        unsigned char c = i < s.size() ? s[i] : 0;
+        key = (key << 8) | c;
+    }
+    return key;
+}
+
+// returns true if a's string is less than b's string
+inline bool keyed_less(const Keyed_string &a, const Keyed_string &b)
+{
+    if (a.key != b.key)
+        return a.key < b.key;
+
+    // the keys are equal, so if both strings have at least 8 characters then
+    // their first 8 characters are the same and don't need to be compared
+    if (a.s->size() >= 8 && b.s->size() >= 8)
+        return a.s->compare(8, string::npos, *b.s, 8, string::npos) < 0;
+    return *a.s < *b.s;
+}
+
+// Sorts v into ascending order with a stable mergesort on the prefix keys.
+// Each string is moved once, after the keys are sorted.
+inline void prefix_key_sort(vector<string> &v)
+{
+    const int n = v.size();
+    vector<Keyed_string> keyed(n);
+    for (int i = 0; i < n; i++)
+    {
+        keyed[i] = {prefix_key(v[i]), &v[i]};
+    }
+    cmpt::mergesort(keyed.begin(), keyed.end(), keyed_less);
+
+    vector<string> sorted;
+    sorted.reserve(n);
+    for (int i = 0; i < n; i++)
+    {
+        sorted.push_back(move(*keyed[i].s));
+    }
+    v.swap(sorted);
+}
+
+} // namespace cmpt
+
+#endif
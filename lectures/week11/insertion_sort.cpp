@@ -1,7 +1,48 @@
 // insertion_sort.cpp
 
+//
+// Reads words from cin one at a time, sorts them with insertion sort, and
+// writes them to cout one per line.
+//
+// Use file redirection to read, e.g.:
+//
+//   > ./insertion_sort < small.txt
+//
+// With the option --msd the words are sorted with MSD radix sort (see
+// cmpt_string_sort.h) instead, which is fast enough for all of ospd.txt:
+//
+//   > ./insertion_sort --msd < ospd_shuffled.txt | diff - ospd_sorted.txt
+//
+// With the option --indirect insertion sort sorts the positions of the words
+// (ints) instead of the words themselves, and then each word is moved once to
+// its place (see cmpt::argsort and cmpt::apply_permutation in
+// cmpt_algorithm.h). Moving an int is cheaper than moving a string, especially
+// a long one:
+//
+//   > ./insertion_sort --indirect < small.txt
+//
+// With the option --top K only the first K words in sorted order are printed.
+// They are found as the words are read (see cmpt::top_k in cmpt_algorithm.h),
+// so only K words are ever in memory:
+//
+//   > ./insertion_sort --top 10 < ospd_shuffled.txt
+//
+// With the option --unique each word is printed only once, and with --count
+// each word is printed once after the number of times it occurs, like
+// sort | uniq -c. Each word is inserted into its place as it's read, and a
+// repeated word only adds 1 to its count, so only one copy of each word is
+// ever in memory:
+//
+//   > ./insertion_sort --count < ../week1/wordcount/austenPride.txt
+//
+
+#include "cmpt_algorithm.h"
+#include "cmpt_string_sort.h"
 #include <cassert>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -54,18 +95,151 @@ void insertion_sort(vector<string> &v)
 
 } // insertion_sort
 
-int main()
+// Returns the permutation that sorts v, i.e. v[p[0]] <= v[p[1]] <= ... The
+// same as insertion_sort, except that it moves ints (positions in v) instead of
+// strings, so v itself never changes.
+vector<int> insertion_argsort(const vector<string> &v)
+{
+    vector<int> p(v.size());
+    for (int i = 0; i < p.size(); ++i)
+    {
+        p[i] = i;
+    }
+
+    for (int i = 1; i < p.size(); ++i)
+    {
+        int key = p[i];
+        int j = i - 1;
+        while (j >= 0 && v[p[j]] > v[key])
+        {
+            p[j + 1] = p[j];
+            --j;
+        }
+        p[j + 1] = key;
+    }
+    return p;
+} // insertion_argsort
+
+// Pre-condition:
+//    words is in ascending sorted order with no duplicates, and counts[i] is
+//    the number of times words[i] has been inserted
+// Post-condition:
+//    same as the pre-condition, with w inserted
+//
+// If w is already in words then only its count goes up, so duplicates never
+// take any memory. A binary search finds where w goes, since most words in
+// ordinary text are repeats and a linear search would be slow for them.
+void insert_unique(vector<string> &words, vector<int> &counts, const string &w)
 {
+    // find the first word >= w
+    int lo = 0;
+    int hi = words.size();
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (words[mid] < w)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo < words.size() && words[lo] == w)
+    {
+        counts[lo]++;
+    }
+    else
+    {
+        words.insert(words.begin() + lo, w);
+        counts.insert(counts.begin() + lo, 1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // --msd chooses MSD radix sort, --indirect sorts positions instead of
+    // words, --top K prints only the first K words, and --unique and --count
+    // print each word once
+    bool msd = false;
+    int top = 0;
+    bool unique = false;
+    bool count = false;
+    bool indirect = false;
+    if (argc == 2 && string(argv[1]) == "--msd")
+    {
+        msd = true;
+    }
+    else if (argc == 2 && string(argv[1]) == "--indirect")
+    {
+        indirect = true;
+    }
+    else if (argc == 2 && string(argv[1]) == "--unique")
+    {
+        unique = true;
+    }
+    else if (argc == 2 && string(argv[1]) == "--count")
+    {
+        count = true;
+    }
+    else if (argc == 3 && string(argv[1]) == "--top")
+    {
+        top = max(1, atoi(argv[2]));
+    }
+    else if (argc != 1)
+    {
+        cout << "Usage: " << argv[0]
+             << " [--msd | --indirect | --top K | --unique | --count]"
+             << " < words.txt\n";
+        return 1;
+    }
+
+    if (top > 0)
+    {
+        for (const string &w : cmpt::top_k(istream_iterator<string>(cin),
+                                           istream_iterator<string>(), top))
+        {
+            cout << w << "\n";
+        }
+        return 0;
+    }
+
     // read in the words from cin
     vector<string> words;
     string w;
+    if (unique || count)
+    {
+        vector<int> counts;
+        while (cin >> w)
+        {
+            insert_unique(words, counts, w);
+        }
+        for (int i = 0; i < words.size(); i++)
+        {
+            if (count)
+                cout << setw(7) << counts[i] << " ";
+            cout << words[i] << "\n";
+        }
+        return 0;
+    }
+
     while (cin >> w)
     {
         words.push_back(w);
     }
 
-    // randomly re-arrange them
-    insertion_sort(words);
+    // sort them
+    if (msd)
+    {
+        cmpt::msd_radix_sort(words);
+    }
+    else if (indirect)
+    {
+        vector<int> p = insertion_argsort(words);
+        cmpt::apply_permutation(words.begin(), p);
+    }
+    else
+    {
+        insertion_sort(words);
+    }
 
     // write them to cout
     for (string w : words)
@@ -0,0 +1,247 @@
+// lookup.cpp
+
+//
+// Checks if words are in the dictionary ospd_sorted.txt, using the
+// memory-mapped dictionary in cmpt_dictionary.h. Words given on the command
+// line are each reported as found or not found:
+//
+//   > ./lookup cat cta
+//   cat is in the dictionary
+//   cta is NOT in the dictionary
+//
+// With no words, it reads words from cin and prints the ones that are not in
+// the dictionary, like a simple spell checker:
+//
+//   > ./lookup < words.txt
+//
+// --test runs the tests, and --bench times loading the dictionary and looking
+// up words, compared to reading it into a vector<string> and using binary
+// search on that:
+//
+//   > ./lookup --test
+//   > ./lookup --bench
+//
+
+#include "cmpt_bench.h"
+#include "cmpt_dictionary.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+const string dictionary_file = "ospd_sorted.txt";
+
+// reads the words of a file into a vector, the usual way
+vector<string> read_words(const string &filename)
+{
+    ifstream in(filename);
+    vector<string> words;
+    string w;
+    while (in >> w)
+    {
+        words.push_back(w);
+    }
+    return words;
+}
+
+// writes contents to a file named filename, replacing what was there
+void write_file(const string &filename, const string &contents)
+{
+    ofstream out(filename, ios::binary);
+    out << contents;
+}
+
+void test_mapped_dictionary()
+{
+    cout << "calling test_mapped_dictionary() ...\n";
+    const string test_file = "lookup_test.txt";
+
+    // a small dictionary
+    write_file(test_file, "ant\nbee\ncat\ncat\ndog\n");
+    {
+        cmpt::Mapped_dictionary dict(test_file);
+        assert(dict.size() == 5);
+        assert(dict[0] == "ant");
+        assert(dict[4] == "dog");
+        assert(dict.find("ant") == 0);
+        assert(dict.find("cat") == 2); // the first copy
+        assert(dict.find("dog") == 4);
+        assert(dict.find("") == -1);
+        assert(dict.find("a") == -1);
+        assert(dict.find("ca") == -1);
+        assert(dict.find("cats") == -1);
+        assert(dict.find("zebra") == -1);
+        assert(dict.contains("bee"));
+        assert(!dict.contains("be"));
+    }
+
+    // the last line has no '\n', and lines end with "\r\n"
+    write_file(test_file, "ant\nbee");
+    {
+        cmpt::Mapped_dictionary dict(test_file);
+        assert(dict.size() == 2);
+        assert(dict[1] == "bee");
+        assert(dict.find("bee") == 1);
+    }
+    write_file(test_file, "ant\r\nbee\r\n");
+    {
+        cmpt::Mapped_dictionary dict(test_file);
+        assert(dict.size() == 2);
+        assert(dict[0] == "ant");
+        assert(dict.find("bee") == 1);
+    }
+    write_file(test_file, "ant\r\nbee");
+    {
+        cmpt::Mapped_dictionary dict(test_file);
+        assert(dict[1] == "bee");
+    }
+
+    // empty files and files with one word
+    write_file(test_file, "");
+    {
+        cmpt::Mapped_dictionary dict(test_file);
+        assert(dict.size() == 0);
+        assert(dict.find("ant") == -1);
+    }
+    write_file(test_file, "ant\n");
+    {
+        cmpt::Mapped_dictionary dict(test_file);
+        assert(dict.size() == 1);
+        assert(dict.find("ant") == 0);
+        assert(dict.find("bee") == -1);
+    }
+    remove(test_file.c_str());
+
+    // a missing file is an error
+    try
+    {
+        cmpt::Mapped_dictionary dict("no_such_file.txt");
+        assert(false);
+    }
+    catch (const runtime_error &e)
+    {
+        // expected
+    }
+
+    // every word of the real dictionary is found at its own line, and
+    // changing a word gives the same answer as binary search on a vector
+    vector<string> words = read_words(dictionary_file);
+    cmpt::Mapped_dictionary dict(dictionary_file);
+    assert(dict.size() == words.size());
+    for (int i = 0; i < words.size(); i++)
+    {
+        assert(dict[i] == words[i]);
+        assert(dict.find(words[i]) == i);
+        string w = words[i] + "s";
+        bool expected = binary_search(words.begin(), words.end(), w);
+        assert(dict.contains(w) == expected);
+        w = words[i].substr(1);
+        expected = binary_search(words.begin(), words.end(), w);
+        assert(dict.contains(w) == expected);
+    }
+
+    cout << "... test_mapped_dictionary() done: all tests passed\n";
+}
+
+void do_lookup_bench()
+{
+    vector<string> words = read_words(dictionary_file);
+
+    // half the queries are words, and half are words with one letter changed,
+    // which are usually not words
+    const int num_queries = 1 << 20;
+    vector<string> queries;
+    for (int i = 0; i < num_queries; i++)
+    {
+        string w = words[rand() % words.size()];
+        if (i % 2 == 1)
+            w[rand() % w.size()] = 'a' + rand() % 26;
+        queries.push_back(w);
+    }
+
+    cmpt::Bench bench;
+    long found = 0;
+    vector<string> loaded;
+    bench.run("load: vector<string>", words.size(), []() {},
+              [&]() { loaded = read_words(dictionary_file); });
+    bench.run("load: Mapped_dictionary", words.size(), []() {},
+              [&]()
+              {
+                  cmpt::Mapped_dictionary dict(dictionary_file);
+                  found += dict.size();
+              });
+
+    bench.run("lookup: vector<string>", num_queries, []() {},
+              [&]()
+              {
+                  for (const string &q : queries)
+                      found += binary_search(words.begin(), words.end(), q);
+              });
+    cmpt::Mapped_dictionary dict(dictionary_file);
+    bench.run("lookup: Mapped_dictionary", num_queries, []() {},
+              [&]()
+              {
+                  for (const string &q : queries)
+                      found += dict.contains(q);
+              });
+    bench.print_table(cout);
+
+    // a string is sizeof(string) bytes, plus its characters if they don't fit
+    // inside the string itself
+    long vector_bytes = words.capacity() * sizeof(string);
+    long file_bytes = 0;
+    for (const string &w : words)
+    {
+        if (w.size() >= sizeof(string) / 2)
+            vector_bytes += w.capacity() + 1;
+        file_bytes += w.size() + 1;
+    }
+    cout << "\nmemory used for " << words.size() << " words:\n"
+         << "  vector<string>:    about " << vector_bytes / 1024 << " KB\n"
+         << "  Mapped_dictionary: about "
+         << (file_bytes + 4 * (words.size() + 1)) / 1024 << " KB\n"
+         << "(" << found << " words were found)\n";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 2 && string(argv[1]) == "--test")
+    {
+        test_mapped_dictionary();
+        return 0;
+    }
+    if (argc >= 2 && string(argv[1]) == "--bench")
+    {
+        do_lookup_bench();
+        return 0;
+    }
+
+    cmpt::Mapped_dictionary dict(dictionary_file);
+    if (argc >= 2)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            string w = argv[i];
+            if (dict.contains(w))
+                cout << w << " is in the dictionary\n";
+            else
+                cout << w << " is NOT in the dictionary\n";
+        }
+    }
+    else
+    {
+        string w;
+        while (cin >> w)
+        {
+            if (!dict.contains(w))
+                cout << w << "\n";
+        }
+    }
+}
@@ -1,88 +1,1598 @@
 // mergesort.cpp
 
+//
+// Reads words from cin one at a time, sorts them with mergesort, and writes
+// them to cout one per line.
+//
+// Use file redirection to read, e.g.:
+//
+//   > ./mergesort < ospd_shuffled.txt > sorted.txt
+//
+// With the option -j N the sort is done in parallel using at most N threads:
+//
+//   > ./mergesort -j 4 < ospd_shuffled.txt | diff - ospd_sorted.txt
+//
+// The output is the same no matter how many threads are used.
+//
+// With the option --msd the words are sorted with MSD radix sort (see
+// cmpt_string_sort.h) instead of mergesort:
+//
+//   > ./mergesort --msd < ospd_shuffled.txt | diff - ospd_sorted.txt
+//
+// With the option --prefix the words are sorted with mergesort, but most
+// comparisons are done on 8-character integer keys (see cmpt_string_sort.h):
+//
+//   > ./mergesort --prefix < ospd_shuffled.txt | diff - ospd_sorted.txt
+//
+// With the option --adaptive the words are sorted with adaptive mergesort,
+// which is much faster when the words are already partly in order:
+//
+//   > ./mergesort --adaptive < ospd_sorted.txt | diff - ospd_sorted.txt
+//
+// With the option --bench nothing is printed except a table (see cmpt_bench.h)
+// of how long the different sorts take on the words from cin, on those words
+// sorted, and on those words sorted in reverse:
+//
+//   > ./mergesort --bench < ospd_shuffled.txt
+//
+// With the option --external the words don't all need to fit in memory. At
+// most about -m MB megabytes of words (default 64) are read at a time, and each
+// batch is sorted and written to a temporary file in the directory given by
+// --tmpdir DIR (default is the system's temporary directory). The temporary
+// files are then merged, a limited number at a time, and written to cout. If
+// a temporary file can't be written, the program stops with an error:
+//
+//   > ./mergesort --external -m 1 < ospd_shuffled.txt | diff - ospd_sorted.txt
+//
+// With the option --top K only the first K words in sorted order are printed.
+// They are found as the words are read (see cmpt::top_k in cmpt_algorithm.h),
+// so only K words are ever in memory:
+//
+//   > ./mergesort --top 10 < ospd_shuffled.txt
+//
+// With the option --unique each word is printed only once, and with --count
+// each word is printed once after the number of times it occurs. It's the same
+// as sort | uniq and sort | uniq -c, but the duplicates are removed while
+// the words are read and merged (see read_unique), so there is no second pass
+// over the words and only one copy of each word is kept in memory:
+//
+//   > ./mergesort --count < ../week1/wordcount/austenPride.txt
+//
+// With the option --allocs the number of times memory was allocated while
+// sorting is written to cerr. mergesort moves strings instead of copying them,
+// so it allocates just one scratch vector no matter how many words there are.
+// Counting allocations slows the program down, so --allocs only works in a
+// version built with make mergesort_allocs:
+//
+//   > ./mergesort_allocs --allocs < ospd_shuffled.txt > /dev/null
+//
+// With the option --merge A B the words in the files A and B, which must
+// already be sorted, are merged (with -j N threads, default one per core) and
+// written to cout:
+//
+//   > ./mergesort --merge sorted1.txt sorted2.txt > all_sorted.txt
+//
+
+#include "cmpt_algorithm.h"
+#include "cmpt_bench.h"
+#include "cmpt_error.h"
+#include "cmpt_string_sort.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <queue>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 
 using namespace std;
 
-// Returns a new vector<string> containing the elements of v from v[begin] to
-// v[end - 1].
-vector<string> slice(const vector<string> &v, int begin, int end)
+//
+// Counting allocations
+//
+// Every new, including the ones inside vector and string, calls the global
+// operator new to get memory. Replacing it with a version that counts its calls
+// lets us check how many allocations a sort does, e.g. that mergesort moves
+// strings instead of copying them.
+//
+// Counting slows down every allocation, and so it is only compiled in when
+// COUNT_ALLOCS is defined, e.g. by building with make mergesort_allocs. In the
+// normal program alloc_count is always 0.
+//
+
+#ifdef COUNT_ALLOCS
+atomic<long> alloc_count{0};
+
+void *operator new(size_t size)
 {
-    vector<string> result(end - begin, "");
-    for (int i = begin; i < end; i++)
-    {
-        result[i - begin] = v[i];
-    }
-    return result;
+    alloc_count++;
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+// noinline stops g++ from seeing the free inlined next to a new and warning
+// (wrongly) that they don't match
+__attribute__((noinline)) void operator delete(void *p) noexcept
+{
+    free(p);
 }
 
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+#else
+const long alloc_count = 0;
+#endif
+
 // Pre-condition:
-//    a and b both in ascending sorted order
+//    v[begin] to v[mid - 1] is in ascending sorted order
+//    v[mid] to v[end - 1] is in ascending sorted order
+//    tmp.size() >= mid
 // Post-condition:
-//    result is in ascending sorted order and contains all strings from a and b
-vector<string> merge(const vector<string> &v, const vector<string> &w)
+//    v[begin] to v[end - 1] is in ascending sorted order
+//
+// The strings are moved, never copied: the left half is moved into tmp, and
+// then both halves are merged back into v. Moving a string only moves the
+// pointer to its characters (or, for a short string, the few characters stored
+// inside the string itself), so merging never allocates any memory.
+void merge(vector<string> &v, vector<string> &tmp, int begin, int mid, int end)
 {
-    vector<string> result(v.size() + w.size(), "");
-    int a = 0;
-    int b = 0;
-    for (int i = 0; i < result.size(); i++)
+    for (int i = begin; i < mid; i++)
     {
-        if (a >= v.size())
+        tmp[i] = move(v[i]);
+    }
+
+    int a = begin;
+    int b = mid;
+    int i = begin;
+    while (a < mid && b < end)
+    {
+        if (v[b] < tmp[a])
         {
-            result[i] = w[b];
+            v[i] = move(v[b]);
             b++;
         }
-        else if (b >= w.size())
+        else
         {
-            result[i] = v[a];
+            v[i] = move(tmp[a]);
             a++;
         }
-        else if (v[a] < w[b])
+        i++;
+    }
+    while (a < mid)
+    {
+        v[i] = move(tmp[a]);
+        a++;
+        i++;
+    }
+    // any strings left in the right half are already in the right place
+}
+
+// Sorts v[begin] to v[end - 1], using tmp[begin] to tmp[end - 1] as scratch
+// space.
+void mergesort(vector<string> &v, vector<string> &tmp, int begin, int end)
+{
+    if (end - begin <= 1)
+        return; // base case
+
+    int mid = begin + (end - begin) / 2;
+    mergesort(v, tmp, begin, mid);
+    mergesort(v, tmp, mid, end);
+    merge(v, tmp, begin, mid, end);
+}
+
+// Sorts v into ascending order. The only memory allocated is for tmp, which
+// holds empty strings until strings are moved into it.
+void mergesort(vector<string> &v)
+{
+    vector<string> tmp(v.size());
+    mergesort(v, tmp, 0, v.size());
+}
+
+//
+// Parallel mergesort
+//
+// Like mergesort above, the parallel version sorts v in place and moves strings
+// between v and a scratch vector instead of copying them. The recursion is
+// split across at most a given number of threads, and the merges are split
+// across threads as well, by cmpt::parallel_merge (see cmpt_algorithm.h), so
+// that the final merge of the two halves doesn't run on a single thread.
+// Reading the halves through move iterators makes parallel_merge move the
+// strings instead of copying them.
+//
+
+// Ranges smaller than this are always sorted by a single thread, since
+// starting a thread costs more than the work it would do.
+const int parallel_cutoff = 8192;
+
+// Sorts v[begin] to v[end - 1] using up to threads threads, with tmp[begin] to
+// tmp[end - 1] as scratch space. Ranges that one thread sorts are sorted by
+// mergesort, so the threads never use the same part of tmp.
+void parallel_sort(vector<string> &v, vector<string> &tmp,
+                   int begin, int end, int threads)
+{
+    const int n = end - begin;
+    if (threads <= 1 || n < parallel_cutoff)
+    {
+        mergesort(v, tmp, begin, end);
+        return;
+    }
+
+    const int mid = (begin + end) / 2;
+    const int left_threads = threads / 2;
+    thread left(parallel_sort, ref(v), ref(tmp), begin, mid, left_threads);
+    parallel_sort(v, tmp, mid, end, threads - left_threads);
+    left.join();
+
+    // move both sorted halves into tmp, and merge them back into v
+    for (int i = begin; i < end; i++)
+    {
+        tmp[i] = move(v[i]);
+    }
+    auto from = make_move_iterator(tmp.begin());
+    cmpt::parallel_merge(from + begin, from + mid, from + mid, from + end,
+                         v.begin() + begin, threads);
+} // parallel_sort
+
+// Sorts v using at most threads threads.
+void parallel_mergesort(vector<string> &v, int threads)
+{
+    vector<string> tmp(v.size());
+    parallel_sort(v, tmp, 0, v.size(), max(1, threads));
+    assert(is_sorted(v.begin(), v.end()));
+}
+
+// The strings in these tests are too long to be stored inside the string
+// objects, so copying any of them would allocate memory.
+void test_mergesort_allocs()
+{
+    cout << "Calling test_mergesort_allocs ...\n";
+#ifndef COUNT_ALLOCS
+    cout << " ... test_mergesort_allocs skipped: build with make "
+         << "mergesort_allocs to count allocations\n";
+    return;
+#endif
+    vector<string> v;
+    for (int i = 0; i < 5 * parallel_cutoff; i++)
+    {
+        v.push_back("a long word for testing " + to_string((i * 7919) % 10007));
+    }
+    vector<string> expected = v;
+    sort(expected.begin(), expected.end());
+
+    // only tmp is allocated
+    vector<string> w = v;
+    long before = alloc_count;
+    mergesort(w);
+    assert(alloc_count - before == 1);
+    assert(w == expected);
+
+    // tmp, plus the threads
+    w = v;
+    before = alloc_count;
+    parallel_mergesort(w, 4);
+    long thread_allocs = alloc_count - before - 1;
+    assert(thread_allocs < 16);
+    assert(w == expected);
+
+    cout << " ... test_mergesort_allocs done: all tests passed\n";
+}
+
+void test_parallel_mergesort()
+{
+    cout << "Calling test_parallel_mergesort ...\n";
+    vector<vector<string>> tests = {
+        {},
+        {"a"},
+        {"b", "a"},
+        {"cat", "ant", "cat", "bee", "ant"},
+    };
+
+    // a big test, so that the parallel code is used
+    vector<string> big;
+    for (int i = 0; i < 5 * parallel_cutoff; i++)
+    {
+        big.push_back(to_string((i * 7919) % 10007));
+    }
+    tests.push_back(big);
+
+    for (vector<string> v : tests)
+    {
+        vector<string> expected = v;
+        mergesort(expected);
+        for (int threads = 1; threads <= 8; threads++)
         {
-            result[i] = v[a];
-            a++;
+            vector<string> w = v;
+            parallel_mergesort(w, threads);
+            assert(w == expected);
+        }
+    }
+    cout << " ... test_parallel_mergesort done: all tests passed\n";
+}
+
+void test_msd_radix_sort()
+{
+    cout << "Calling test_msd_radix_sort ...\n";
+    vector<vector<string>> tests = {
+        {},
+        {"a"},
+        {"b", "a"},
+        {"", "a", ""},
+        {"cart", "car", "cat", "ca", "c", "", "cart", "car"},
+        {"\xff", "z", "\x01", "a"}, // chars above 127 sort last, like <
+    };
+
+    // a big test, so that the buckets are bigger than msd_insertion_cutoff
+    vector<string> big;
+    for (int i = 0; i < 5000; i++)
+    {
+        big.push_back("pre" + to_string((i * 7919) % 1009));
+    }
+    tests.push_back(big);
+
+    for (vector<string> v : tests)
+    {
+        vector<string> expected = v;
+        mergesort(expected);
+        cmpt::msd_radix_sort(v);
+        assert(v == expected);
+    }
+    cout << " ... test_msd_radix_sort done: all tests passed\n";
+}
+
+void test_prefix_key_sort()
+{
+    cout << "Calling test_prefix_key_sort ...\n";
+    assert(cmpt::prefix_key("") == 0);
+    assert(cmpt::prefix_key("a") == uint64_t('a') << 56);
+    assert(cmpt::prefix_key("abcdefghij") == cmpt::prefix_key("abcdefgh"));
+    assert(cmpt::prefix_key("abc") < cmpt::prefix_key("abd"));
+    assert(cmpt::prefix_key("ab") < cmpt::prefix_key("abc"));
+    assert(cmpt::prefix_key("\xff") > cmpt::prefix_key("z"));
+
+    vector<vector<string>> tests = {
+        {},
+        {"a"},
+        {"b", "a"},
+        {"", "a", ""},
+        {"abcdefghij", "abcdefgh", "abcdefghi", "abcdefg", "abcdefghij"},
+        {"prefixes_are_long_b", "prefixes_are_long_a", "prefixes_are_long"},
+        {"ab", string("ab\0", 3), "a", string("ab\0c", 4)},
+        {"\xff", "z", "\x01", "a"},
+    };
+    vector<string> big;
+    for (int i = 0; i < 5000; i++)
+    {
+        big.push_back("sameprefix" + to_string((i * 7919) % 1009));
+    }
+    tests.push_back(big);
+
+    for (vector<string> v : tests)
+    {
+        vector<string> expected = v;
+        mergesort(expected);
+        cmpt::prefix_key_sort(v);
+        assert(v == expected);
+    }
+    cout << " ... test_prefix_key_sort done: all tests passed\n";
+}
+
+//
+// Adaptive mergesort
+//
+// Real data is often already partly sorted, but mergesort does the same
+// n log n work no matter what order the strings are in. Adaptive mergesort
+// (similar to Python's Timsort) first finds the runs of v, i.e. the parts that
+// are already in ascending or descending order, and then merges neighbouring
+// runs. If v is already sorted it is one big run, and the sort takes linear
+// time.
+//
+
+// Runs shorter than this are made longer by insertion sort.
+const int min_run_length = 32;
+
+// When one run supplies this many strings in a row to a merge, the merge
+// starts galloping, i.e. it looks for how many more strings it can take from
+// that run all at once.
+const int min_gallop = 7;
+
+// Returns the first i in [begin, end) such that x < v[i], or end if there isn't
+// one. It checks v[begin], v[begin + 1], v[begin + 3], v[begin + 7], ... until
+// it passes x, and then does a binary search. This is faster than a plain
+// binary search when the answer is near begin.
+int gallop_upper(const string &x, const vector<string> &v, int begin, int end)
+{
+    int lo = begin; // v[begin] to v[lo - 1] are all <= x
+    int hi = begin; // x < v[hi], or hi is end
+    int step = 1;
+    while (hi < end && !(x < v[hi]))
+    {
+        lo = hi + 1;
+        hi = lo + step;
+        step *= 2;
+    }
+    hi = min(hi, end);
+    return upper_bound(v.begin() + lo, v.begin() + hi, x) - v.begin();
+}
+
+// Same as gallop_upper, but returns the first i such that x <= v[i].
+int gallop_lower(const string &x, const vector<string> &v, int begin, int end)
+{
+    int lo = begin; // v[begin] to v[lo - 1] are all < x
+    int hi = begin; // x <= v[hi], or hi is end
+    int step = 1;
+    while (hi < end && v[hi] < x)
+    {
+        lo = hi + 1;
+        hi = lo + step;
+        step *= 2;
+    }
+    hi = min(hi, end);
+    return lower_bound(v.begin() + lo, v.begin() + hi, x) - v.begin();
+}
+
+// Pre-condition:
+//    v[begin] to v[sorted_end - 1] is in ascending sorted order
+// Post-condition:
+//    v[begin] to v[end - 1] is in ascending sorted order
+//
+// Each string is inserted after the strings equal to it, so the sort is
+// stable.
+void binary_insertion_sort(vector<string> &v, int begin, int sorted_end,
+                           int end)
+{
+    for (int i = sorted_end; i < end; i++)
+    {
+        auto pos = upper_bound(v.begin() + begin, v.begin() + i, v[i]);
+        rotate(pos, v.begin() + i, v.begin() + i + 1);
+    }
+}
+
+// Returns the length of the run that starts at v[begin]. If the run is
+// descending it is reversed, so after this the run is always ascending. Only
+// strictly descending runs are reversed, so that equal strings never change
+// order.
+int find_run(vector<string> &v, int begin, int end)
+{
+    int i = begin + 1;
+    if (i >= end)
+        return end - begin;
+
+    if (v[i] < v[i - 1])
+    {
+        while (i < end && v[i] < v[i - 1])
+            i++;
+        reverse(v.begin() + begin, v.begin() + i);
+    }
+    else
+    {
+        while (i < end && !(v[i] < v[i - 1]))
+            i++;
+    }
+    return i - begin;
+}
+
+// Pre-condition:
+//    v[begin] to v[mid - 1] is in ascending sorted order
+//    v[mid] to v[end - 1] is in ascending sorted order
+// Post-condition:
+//    v[begin] to v[end - 1] is in ascending sorted order
+//
+// tmp is scratch space for the left run.
+void merge_runs(vector<string> &v, vector<string> &tmp,
+                int begin, int mid, int end)
+{
+    // strings at the start of the left run that are <= the first string of
+    // the right run are already in their place, and so are strings at the end
+    // of the right run that are >= the last string of the left run
+    begin = gallop_upper(v[mid], v, begin, mid);
+    if (begin == mid)
+        return;
+    end = gallop_lower(v[mid - 1], v, mid, end);
+
+    // move the left run out of the way, then merge it and the right run back
+    // into v from left to right
+    const int left_n = mid - begin;
+    if (tmp.size() < left_n)
+        tmp.resize(left_n);
+    for (int i = 0; i < left_n; i++)
+    {
+        tmp[i] = move(v[begin + i]);
+    }
+
+    int a = 0;       // next string of the left run, in tmp
+    int b = mid;     // next string of the right run, in v
+    int out = begin; // where the next string goes
+    int a_wins = 0;  // number of strings in a row taken from the left run
+    int b_wins = 0;  // number of strings in a row taken from the right run
+    while (a < left_n && b < end)
+    {
+        if (v[b] < tmp[a])
+        {
+            v[out++] = move(v[b++]);
+            b_wins++;
+            a_wins = 0;
         }
         else
         {
-            result[i] = w[b];
-            b++;
+            v[out++] = move(tmp[a++]);
+            a_wins++;
+            b_wins = 0;
+        }
+
+        if (a_wins >= min_gallop && a < left_n && b < end)
+        {
+            // take all the left strings <= v[b] at once
+            int stop = gallop_upper(v[b], tmp, a, left_n);
+            while (a < stop)
+                v[out++] = move(tmp[a++]);
+            a_wins = 0;
         }
+        else if (b_wins >= min_gallop && a < left_n && b < end)
+        {
+            // take all the right strings < tmp[a] at once
+            int stop = gallop_lower(tmp[a], v, b, end);
+            while (b < stop)
+                v[out++] = move(v[b++]);
+            b_wins = 0;
+        }
+    } // while
+
+    // any strings left in the right run are already in place
+    while (a < left_n)
+    {
+        v[out++] = move(tmp[a++]);
     }
-    return result;
+} // merge_runs
+
+// Returns the minimum run length to use for sorting n strings. It's chosen so
+// that n / min_run is a power of 2, or a bit less than one, which keeps the
+// merges balanced.
+int compute_min_run(int n)
+{
+    int r = 0;
+    while (n >= 2 * min_run_length)
+    {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
 }
 
-void mergesort(vector<string> &v)
+// A run is v[begin] to v[begin + length - 1].
+struct Run
 {
-    if (v.size() <= 1)
-        return; // base case
+    int begin;
+    int length;
+};
+
+// Merges runs[i] and runs[i + 1] into one run.
+void merge_at(vector<string> &v, vector<string> &tmp, vector<Run> &runs, int i)
+{
+    Run &a = runs[i];
+    const Run &b = runs[i + 1];
+    merge_runs(v, tmp, a.begin, b.begin, b.begin + b.length);
+    a.length += b.length;
+    runs.erase(runs.begin() + i + 1);
+}
+
+// Merges runs at the top of the stack until these are true for the top
+// three runs X, Y, Z (Z is on top):
+//    X.length > Y.length + Z.length
+//    Y.length > Z.length
+// This keeps merges balanced and the stack short.
+void merge_collapse(vector<string> &v, vector<string> &tmp, vector<Run> &runs)
+{
+    while (runs.size() > 1)
+    {
+        // runs[n + 1] is Z, runs[n] is Y, runs[n - 1] is X, and runs[n - 2] is
+        // the run W under X, which must also be longer than X and Y together
+        int n = runs.size() - 2;
+        bool x_too_short =
+            n > 0 && runs[n - 1].length <= runs[n].length + runs[n + 1].length;
+        bool w_too_short =
+            n > 1 && runs[n - 2].length <= runs[n - 1].length + runs[n].length;
+        if (x_too_short || w_too_short)
+        {
+            if (runs[n - 1].length < runs[n + 1].length)
+                n--;
+        }
+        else if (runs[n].length > runs[n + 1].length)
+        {
+            break;
+        }
+        merge_at(v, tmp, runs, n);
+    }
+}
+
+void adaptive_mergesort(vector<string> &v)
+{
+    const int n = v.size();
+    const int min_run = compute_min_run(n);
+    vector<string> tmp;
+    vector<Run> runs;
+    int begin = 0;
+    while (begin < n)
+    {
+        int length = find_run(v, begin, n);
+
+        // make short runs min_run long
+        if (length < min_run)
+        {
+            int forced = min(min_run, n - begin);
+            binary_insertion_sort(v, begin, begin + length, begin + forced);
+            length = forced;
+        }
+
+        runs.push_back({begin, length});
+        merge_collapse(v, tmp, runs);
+        begin += length;
+    }
+
+    // merge whatever runs are left, from the top of the stack down
+    while (runs.size() > 1)
+    {
+        merge_at(v, tmp, runs, runs.size() - 2);
+    }
+    assert(is_sorted(v.begin(), v.end()));
+} // adaptive_mergesort
+
+void test_adaptive_mergesort()
+{
+    cout << "Calling test_adaptive_mergesort ...\n";
+    vector<vector<string>> tests = {
+        {},
+        {"a"},
+        {"b", "a"},
+        {"cat", "ant", "cat", "bee", "ant"},
+    };
+
+    // big tests with long runs, so that galloping is used
+    vector<string> shuffled;
+    for (int i = 0; i < 3000; i++)
+    {
+        shuffled.push_back(to_string((i * 7919) % 1009));
+    }
+    vector<string> sorted = shuffled;
+    mergesort(sorted);
+    vector<string> reversed(sorted.rbegin(), sorted.rend());
+    vector<string> saw = sorted;
+    saw.insert(saw.end(), reversed.begin(), reversed.end());
+    saw.insert(saw.end(), sorted.begin(), sorted.begin() + 100);
+    tests.push_back(shuffled);
+    tests.push_back(sorted);
+    tests.push_back(reversed);
+    tests.push_back(saw);
+
+    for (vector<string> v : tests)
+    {
+        vector<string> expected = v;
+        mergesort(expected);
+        adaptive_mergesort(v);
+        assert(v == expected);
+    }
+    cout << " ... test_adaptive_mergesort done: all tests passed\n";
+}
+
+// Checks that the templates in cmpt_algorithm.h sort strings the same way as
+// mergesort.
+void test_cmpt_algorithm()
+{
+    cout << "Calling test_cmpt_algorithm ...\n";
+    vector<vector<string>> tests = {
+        {},
+        {"a"},
+        {"b", "a"},
+        {"cart", "car", "cat", "ca", "c", "", "cart", "car"},
+    };
+    vector<string> big;
+    for (int i = 0; i < 2000; i++)
+    {
+        big.push_back(to_string((i * 7919) % 1009));
+    }
+    tests.push_back(big);
+
+    for (const vector<string> &v : tests)
+    {
+        vector<string> expected = v;
+        mergesort(expected);
+
+        vector<string> a = v;
+        cmpt::mergesort(a.begin(), a.end());
+        assert(a == expected);
+        a = v;
+        cmpt::generic_sort(a.begin(), a.end());
+        assert(a == expected);
+        a = v;
+        cmpt::binary_insertion_sort(a.begin(), a.end());
+        assert(a == expected);
+        a = v;
+        cmpt::insertion_sort(a.begin(), a.end());
+        assert(a == expected);
 
-    int mid = v.size() / 2;
-    vector<string> left = slice(v, 0, mid);
-    vector<string> right = slice(v, mid, v.size());
-    mergesort(left);
-    mergesort(right);
-    v = merge(left, right);
+        for (const string &w : v)
+        {
+            int i = cmpt::generic_binary_search(expected.begin(),
+                                                expected.end(), w);
+            assert(i >= 0 && expected[i] == w);
+        }
+        assert(cmpt::generic_binary_search(expected.begin(), expected.end(),
+                                           string("zzz")) == -1);
+    }
+
+    // sort by length, then alphabetically for equal lengths: stable sorting
+    // by length keeps the alphabetical order
+    vector<string> words = big;
+    mergesort(words);
+    cmpt::mergesort(words.begin(), words.end(),
+                    [](const string &a, const string &b)
+                    { return a.size() < b.size(); });
+    for (int i = 1; i < words.size(); i++)
+    {
+        assert(words[i - 1].size() < words[i].size() ||
+               (words[i - 1].size() == words[i].size() &&
+                words[i - 1] <= words[i]));
+    }
+
+    // argsort gives the same order as a stable sort, and apply_permutation
+    // puts the elements in that order
+    for (const vector<string> &v : tests)
+    {
+        vector<int> p = cmpt::argsort(v.begin(), v.end());
+        vector<string> expected = v;
+        mergesort(expected);
+        for (int i = 0; i < p.size(); i++)
+        {
+            assert(v[p[i]] == expected[i]);
+        }
+        vector<string> a = v;
+        cmpt::apply_permutation(a.begin(), p);
+        assert(a == expected);
+    }
+
+    // records sorted by age only: equal ages must stay in their original order
+    struct Person
+    {
+        string name;
+        int age;
+    };
+    vector<Person> people = {{"Bob", 30}, {"Alice", 20}, {"Cy", 30},
+                             {"Dee", 20}, {"Eve", 25}};
+    vector<int> p = cmpt::argsort(people.begin(), people.end(),
+                                  [](const Person &a, const Person &b)
+                                  { return a.age < b.age; });
+    assert(p == vector<int>({1, 3, 4, 0, 2}));
+    cmpt::apply_permutation(people.begin(), p);
+    vector<string> names;
+    for (const Person &person : people)
+    {
+        names.push_back(person.name);
+    }
+    assert(names == vector<string>({"Alice", "Dee", "Eve", "Bob", "Cy"}));
+
+    cout << " ... test_cmpt_algorithm done: all tests passed\n";
 }
 
-int main()
+// Returns the words in the file named fname, which must be sorted. Stops the
+// program with an error message if the file can't be read or isn't sorted.
+vector<string> read_sorted_words(const string &fname)
 {
-    // read in the words from cin
+    ifstream in(fname);
+    if (!in)
+    {
+        cout << "Error: can't open " << fname << "\n";
+        exit(1);
+    }
     vector<string> words;
     string w;
-    while (cin >> w)
+    while (in >> w)
     {
         words.push_back(w);
     }
+    if (!is_sorted(words.begin(), words.end()))
+    {
+        cout << "Error: the words in " << fname << " are not sorted\n";
+        exit(1);
+    }
+    return words;
+}
+
+void test_parallel_merge_words()
+{
+    cout << "Calling test_parallel_merge_words ...\n";
+    vector<string> a;
+    vector<string> b;
+    for (int i = 0; i < 100000; i++)
+    {
+        a.push_back(to_string(i % 1000));
+        b.push_back(to_string(i % 777));
+    }
+    mergesort(a);
+    mergesort(b);
+
+    vector<string> expected = a;
+    expected.insert(expected.end(), b.begin(), b.end());
+    mergesort(expected);
+    for (int threads = 1; threads <= 8; threads++)
+    {
+        assert(cmpt::parallel_merge(a, b, threads) == expected);
+    }
+    cout << " ... test_parallel_merge_words done: all tests passed\n";
+}
+
+//
+// Benchmarking
+//
+
+// cmpt::mergesort on all of v; prefix_key_sort is this same mergesort, but
+// sorting keys instead of strings
+void cmpt_mergesort(vector<string> &v)
+{
+    cmpt::mergesort(v.begin(), v.end());
+}
+
+// Times mergesort, adaptive mergesort, MSD radix sort, cmpt::mergesort and
+// prefix key sort on words as given, sorted, and reverse sorted, and prints
+// the results as a table.
+void do_bench(const vector<string> &words)
+{
+    vector<string> sorted = words;
+    mergesort(sorted);
+    vector<string> reversed(sorted.rbegin(), sorted.rend());
+
+    struct Input
+    {
+        string name;
+        const vector<string> &words;
+    };
+    vector<Input> inputs = {
+        {"as given", words},
+        {"sorted", sorted},
+        {"reversed", reversed},
+    };
+
+    struct Sort
+    {
+        string name;
+        void (*sort)(vector<string> &);
+    };
+    vector<Sort> sorts = {
+        {"Mergesort", mergesort},
+        {"Adaptive", adaptive_mergesort},
+        {"MSD radix", cmpt::msd_radix_sort},
+        {"cmpt::mergesort", cmpt_mergesort},
+        {"Prefix key", cmpt::prefix_key_sort},
+    };
+
+    cmpt::Bench bench(5, 1);
+    vector<string> v;
+    for (const Input &in : inputs)
+    {
+        for (const Sort &sort : sorts)
+        {
+            bench.run(
+                sort.name + " (" + in.name + ")", in.words.size(),
+                [&]() { v = in.words; },
+                [&]() { sort.sort(v); });
+        }
+    }
+    bench.print_table(cout);
+} // do_bench
 
-    // randomly re-arrange them
+//
+// External sort
+//
+// To sort more words than fit in memory, the words are read in batches that
+// do fit. Each batch (called a run) is sorted with mergesort and written to
+// its own temporary file. Then the run files are read at the same time, one
+// word at a time, and a heap is used to repeatedly pick the smallest word at
+// the front of any run. That k-way merge is the same as the merge of two
+// vectors in merge, except it merges k files.
+//
+// Each open run needs a read buffer and a file descriptor, so only so many
+// runs can be merged at once. If there are more runs than that, groups of runs
+// are merged into bigger runs first, until few enough are left.
+//
+// Any file that can't be opened, read, or written throws an error (see
+// cmpt_error.h), and the temporary files are removed before it is passed on.
+//
+
+// Size of the read buffer for each run file.
+const int run_buffer_size = 1 << 16;
+
+// The temporary run files of one external sort. The destructor removes any
+// that are left, so they're removed even if the sort stops with an error.
+struct Run_files
+{
+    string tmpdir;
+    vector<string> names; // files not yet removed
+    int made = 0;         // number of files made so far
+
+    Run_files(const string &dir)
+        : tmpdir(dir)
+    {
+    }
+
+    ~Run_files()
+    {
+        for (const string &fname : names)
+            remove(fname.c_str());
+    }
+
+    // returns the name of a new temporary file
+    string make()
+    {
+        string fname = tmpdir + "/mergesort_run_" + to_string(getpid()) +
+                       "_" + to_string(made) + ".txt";
+        made++;
+        names.push_back(fname);
+        return fname;
+    }
+
+    // removes the file fname made by make
+    void remove_file(const string &fname)
+    {
+        remove(fname.c_str());
+        names.erase(find(names.begin(), names.end(), fname));
+    }
+};
+
+// Reads the words of one sorted run file, one at a time.
+struct Run_reader
+{
+    vector<char> buffer;
+    ifstream in;
+    string fname;
+    string word; // current word of the run
+
+    Run_reader(const string &name)
+        : buffer(run_buffer_size), fname(name)
+    {
+        // the buffer must be set before the file is opened
+        in.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+        in.open(fname);
+        if (!in)
+            cmpt::error("can't open temporary file " + fname);
+    }
+
+    // reads the next word into word; returns false if there are no more
+    bool next()
+    {
+        if (in >> word)
+            return true;
+        if (in.bad())
+            cmpt::error("can't read temporary file " + fname);
+        return false;
+    }
+};
+
+// Sorts words, writes them to a new temporary file, and adds the name of the
+// file to run_names.
+void write_run(vector<string> &words, Run_files &files,
+               vector<string> &run_names)
+{
     mergesort(words);
+    string fname = files.make();
+    ofstream out(fname);
+    if (!out)
+        cmpt::error("can't create temporary file " + fname);
+    for (const string &w : words)
+    {
+        out << w << "\n";
+    }
+    out.close();
+    if (!out)
+        cmpt::error("can't write temporary file " + fname);
+    run_names.push_back(fname);
+    words.clear();
+}
+
+// Merges the sorted run files run_names[begin] to run_names[end - 1] and
+// writes the words, one per line, to out.
+void merge_run_files(const vector<string> &run_names, int begin, int end,
+                     ostream &out)
+{
+    vector<unique_ptr<Run_reader>> runs;
+    for (int i = begin; i < end; i++)
+    {
+        runs.push_back(make_unique<Run_reader>(run_names[i]));
+    }
+
+    // The heap holds the index of every run that still has words, ordered so
+    // the run with the smallest current word is on top. For equal words the
+    // earlier run comes first, so equal words keep their order.
+    auto later = [&runs](int a, int b)
+    {
+        if (runs[a]->word != runs[b]->word)
+            return runs[b]->word < runs[a]->word;
+        return b < a;
+    };
+    priority_queue<int, vector<int>, decltype(later)> heap(later);
+    for (int i = 0; i < runs.size(); i++)
+    {
+        if (runs[i]->next())
+            heap.push(i);
+    }
+
+    // k-way merge
+    while (!heap.empty())
+    {
+        int i = heap.top();
+        heap.pop();
+        out << runs[i]->word << "\n";
+        if (runs[i]->next())
+            heap.push(i);
+    }
+}
+
+// Returns the most runs to merge at once. Their read buffers should fit in
+// budget bytes, and there must be enough file descriptors for the runs, the
+// output, and the ones the program already has open (cin, cout, cerr, ...).
+int max_runs_merged(size_t budget)
+{
+    long fds = sysconf(_SC_OPEN_MAX);
+    if (fds <= 0)
+        fds = 256;
+    long k = min(long(budget / run_buffer_size), fds - 8);
+    return int(max(2L, min(k, 1024L)));
+}
+
+// Reads all the words from in and writes them in sorted order to out, one per
+// line, keeping at most about budget bytes of words in memory at once.
+void external_sort(istream &in, ostream &out, size_t budget,
+                   const string &tmpdir)
+{
+    Run_files files(tmpdir);
+
+    // create the sorted runs
+    vector<string> run_names;
+    vector<string> words;
+    size_t used = 0; // approximate bytes used by words
+    string w;
+    while (in >> w)
+    {
+        used += sizeof(string) + w.size();
+        words.push_back(w);
+        if (used >= budget)
+        {
+            write_run(words, files, run_names);
+            used = 0;
+        }
+    }
+    if (in.bad())
+        cmpt::error("can't read the words to sort");
+    if (!words.empty())
+    {
+        write_run(words, files, run_names);
+    }
+    words.shrink_to_fit();
+
+    // Merge groups of runs into bigger runs until they can all be merged at
+    // once. Each group is next to each other, so equal words keep their order.
+    const int k = max_runs_merged(budget);
+    while (run_names.size() > k)
+    {
+        vector<string> merged_names;
+        for (int begin = 0; begin < run_names.size(); begin += k)
+        {
+            int end = min(begin + k, int(run_names.size()));
+            string fname = files.make();
+            ofstream merged(fname);
+            if (!merged)
+                cmpt::error("can't create temporary file " + fname);
+            merge_run_files(run_names, begin, end, merged);
+            merged.close();
+            if (!merged)
+                cmpt::error("can't write temporary file " + fname);
+            merged_names.push_back(fname);
+            for (int i = begin; i < end; i++)
+                files.remove_file(run_names[i]);
+        }
+        run_names = merged_names;
+    }
+
+    merge_run_files(run_names, 0, run_names.size(), out);
+    out.flush();
+    if (!out)
+        cmpt::error("can't write the sorted words");
+} // external_sort
+
+void test_external_sort()
+{
+    cout << "Calling test_external_sort ...\n";
+    vector<string> tests = {
+        "",
+        "a",
+        "b a",
+        "cat ant cat bee ant",
+        "zoo ask cow bird nose dog ask zoo",
+    };
+    const string tmpdir = filesystem::temp_directory_path().string();
+    for (const string &t : tests)
+    {
+        // sort t in memory
+        istringstream words_in(t);
+        vector<string> words;
+        string w;
+        while (words_in >> w)
+            words.push_back(w);
+        mergesort(words);
+        string expected;
+        for (const string &w : words)
+            expected += w + "\n";
+
+        // sort t with tiny budgets, so that there are many runs
+        for (size_t budget : {1, 40, 100, 1000})
+        {
+            istringstream in(t);
+            ostringstream out;
+            external_sort(in, out, budget, tmpdir);
+            assert(out.str() == expected);
+        }
+    }
+
+    // a temporary directory that doesn't exist is an error, not lost words
+    bool failed = false;
+    try
+    {
+        istringstream in("b a");
+        ostringstream out;
+        external_sort(in, out, 1, tmpdir + "/no_such_dir/no_such_dir");
+    }
+    catch (const runtime_error &e)
+    {
+        failed = true;
+    }
+    assert(failed);
+    cout << " ... test_external_sort done: all tests passed\n";
+}
+
+//
+// Counting words
+//
+// sort | uniq -c sorts all the words, duplicates included, and then makes a
+// second pass to count them. mergesort_unique does both at once: when a merge
+// finds the same word at the front of both halves it keeps one copy and adds
+// their counts. So each merge returns only distinct words, and text with many
+// repeated words (e.g. austenPride.txt, where most words are repeats) has less
+// and less to merge as the sort goes up the recursion.
+//
+// read_unique does the same while reading, a chunk at a time, so that the
+// duplicates never need to be stored at all.
+//
+
+// Pre-condition:
+//    v[begin] to v[left_end - 1] is sorted with no duplicates
+//    v[mid] to v[right_end - 1] is sorted with no duplicates
+//    begin <= left_end <= mid <= right_end
+//    counts[i] is the number of times v[i] occurred
+// Post-condition:
+//    v[begin] to v[result - 1] holds the distinct words of both ranges in
+//    sorted order, with their counts added together in counts
+int merge_unique(vector<string> &v, vector<int> &counts,
+                 vector<string> &tmp, vector<int> &tmp_counts,
+                 int begin, int left_end, int mid, int right_end)
+{
+    for (int i = begin; i < left_end; i++)
+    {
+        tmp[i] = move(v[i]);
+        tmp_counts[i] = counts[i];
+    }
+
+    // i never passes b, so nothing in the right range is overwritten before it
+    // is merged
+    int a = begin;
+    int b = mid;
+    int i = begin;
+    while (a < left_end && b < right_end)
+    {
+        if (v[b] < tmp[a])
+        {
+            counts[i] = counts[b];
+            v[i] = move(v[b]);
+            b++;
+        }
+        else if (tmp[a] < v[b])
+        {
+            counts[i] = tmp_counts[a];
+            v[i] = move(tmp[a]);
+            a++;
+        }
+        else
+        {
+            counts[i] = tmp_counts[a] + counts[b];
+            v[i] = move(tmp[a]);
+            a++;
+            b++;
+        }
+        i++;
+    }
+    while (a < left_end)
+    {
+        counts[i] = tmp_counts[a];
+        v[i] = move(tmp[a]);
+        a++;
+        i++;
+    }
+
+    // if no duplicates were found, the rest of the right range is already in
+    // the right place
+    if (i == b)
+        return right_end;
+    while (b < right_end)
+    {
+        counts[i] = counts[b];
+        v[i] = move(v[b]);
+        b++;
+        i++;
+    }
+    return i;
+} // merge_unique
+
+// Sorts v[begin] to v[end - 1] and removes duplicates. Returns the end of the
+// distinct words, which are in v[begin] to v[result - 1].
+int mergesort_unique(vector<string> &v, vector<int> &counts,
+                     vector<string> &tmp, vector<int> &tmp_counts,
+                     int begin, int end)
+{
+    if (end - begin <= 1)
+    {
+        if (end > begin)
+            counts[begin] = 1;
+        return end; // base case
+    }
+
+    int mid = begin + (end - begin) / 2;
+    int left_end = mergesort_unique(v, counts, tmp, tmp_counts, begin, mid);
+    int right_end = mergesort_unique(v, counts, tmp, tmp_counts, mid, end);
+    return merge_unique(v, counts, tmp, tmp_counts,
+                        begin, left_end, mid, right_end);
+}
+
+// Post-condition:
+//    v holds each distinct word of v once, in sorted order, and counts[i] is
+//    the number of times v[i] occurred
+void mergesort_unique(vector<string> &v, vector<int> &counts)
+{
+    counts.resize(v.size());
+    vector<string> tmp(v.size());
+    vector<int> tmp_counts(v.size());
+    int n = mergesort_unique(v, counts, tmp, tmp_counts, 0, v.size());
+
+    // free the memory used by the duplicates
+    v.resize(n);
+    v.shrink_to_fit();
+    counts.resize(n);
+    counts.shrink_to_fit();
+}
+
+// Words are read and merged into the distinct words in chunks of at least
+// this many words.
+const int unique_chunk_size = 1 << 16;
+
+// Reads all the words from in. Afterwards words holds each distinct word once,
+// in sorted order, and counts[i] is the number of times words[i] occurred.
+//
+// The words are read in chunks. Each chunk is sorted by mergesort_unique,
+// which removes its duplicates, and then merged with merge_unique into the
+// distinct words read so far. So only the distinct words and one chunk are ever
+// in memory, not every copy of every word. A chunk is at least as big as the
+// distinct words so far, so each distinct word is merged only a few times.
+void read_unique(istream &in, vector<string> &words, vector<int> &counts)
+{
+    words.clear();
+    counts.clear();
+    vector<string> tmp;
+    vector<int> tmp_counts;
+    string w;
+    while (true)
+    {
+        const int distinct = words.size();
+        const int chunk_end = distinct + max(unique_chunk_size, distinct);
+        while (words.size() < chunk_end && in >> w)
+        {
+            words.push_back(w);
+        }
+        if (words.size() == distinct)
+            break;
+
+        counts.resize(words.size());
+        tmp.resize(words.size());
+        tmp_counts.resize(words.size());
+        int end = mergesort_unique(words, counts, tmp, tmp_counts,
+                                   distinct, words.size());
+        end = merge_unique(words, counts, tmp, tmp_counts,
+                           0, distinct, distinct, end);
+        words.resize(end);
+        counts.resize(end);
+    }
+}
+
+void test_mergesort_unique()
+{
+    cout << "Calling test_mergesort_unique ...\n";
+    vector<vector<string>> tests = {
+        {},
+        {"a"},
+        {"a", "a"},
+        {"b", "a", "b"},
+        {"cat", "ant", "cat", "bee", "ant", "cat"},
+    };
+
+    // lots of duplicates
+    vector<string> big;
+    for (int i = 0; i < 10000; i++)
+    {
+        big.push_back(to_string((i * 7919) % 101));
+    }
+    tests.push_back(big);
+
+    // more words than fit in one chunk of read_unique
+    vector<string> chunks;
+    for (int i = 0; i < 3 * unique_chunk_size; i++)
+    {
+        chunks.push_back(to_string((i * 7919) % 100003));
+    }
+    tests.push_back(chunks);
+
+    for (vector<string> v : tests)
+    {
+        // count the words the slow way: sort them, then count runs
+        vector<string> expected = v;
+        sort(expected.begin(), expected.end());
+        vector<int> expected_counts;
+        int n = 0;
+        for (int i = 0; i < expected.size(); i++)
+        {
+            if (i > 0 && expected[i] == expected[n - 1])
+            {
+                expected_counts[n - 1]++;
+            }
+            else
+            {
+                expected[n] = expected[i];
+                expected_counts.push_back(1);
+                n++;
+            }
+        }
+        expected.resize(n);
+
+        // read_unique gives the same result, whether the words fit in one
+        // chunk or not
+        string text;
+        for (const string &w : v)
+            text += w + " ";
+        istringstream in(text);
+        vector<string> words;
+        vector<int> word_counts;
+        read_unique(in, words, word_counts);
+        assert(words == expected);
+        assert(word_counts == expected_counts);
+
+        vector<int> counts;
+        mergesort_unique(v, counts);
+        assert(v == expected);
+        assert(counts == expected_counts);
+    }
+    cout << " ... test_mergesort_unique done: all tests passed\n";
+}
+
+int main(int argc, char *argv[])
+{
+    // test_mergesort_allocs();
+    // test_parallel_mergesort();
+    // test_msd_radix_sort();
+    // test_prefix_key_sort();
+    // test_adaptive_mergesort();
+    // test_external_sort();
+    // test_mergesort_unique();
+    // test_cmpt_algorithm();
+    // test_parallel_merge_words();
+
+    // -j N sets the number of threads, and the other options choose which
+    // sort to use
+    int threads = 0;
+    bool msd = false;
+    bool adaptive = false;
+    bool prefix = false;
+    bool bench = false;
+    bool external = false;
+    int memory_mb = 64;
+    string tmpdir = filesystem::temp_directory_path().string();
+    vector<string> merge_files;
+    int top = 0;
+    bool allocs = false;
+    bool unique = false;
+    bool count = false;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc)
+        {
+            i++;
+            threads = atoi(argv[i]);
+        }
+        else if (arg == "--msd")
+        {
+            msd = true;
+        }
+        else if (arg == "--adaptive")
+        {
+            adaptive = true;
+        }
+        else if (arg == "--prefix")
+        {
+            prefix = true;
+        }
+        else if (arg == "--bench")
+        {
+            bench = true;
+        }
+        else if (arg == "--external")
+        {
+            external = true;
+        }
+        else if (arg == "-m" && i + 1 < argc)
+        {
+            i++;
+            memory_mb = atoi(argv[i]);
+        }
+        else if (arg == "--tmpdir" && i + 1 < argc)
+        {
+            i++;
+            tmpdir = argv[i];
+        }
+        else if (arg == "--top" && i + 1 < argc)
+        {
+            i++;
+            top = max(1, atoi(argv[i]));
+        }
+        else if (arg == "--unique")
+        {
+            unique = true;
+        }
+        else if (arg == "--count")
+        {
+            count = true;
+        }
+        else if (arg == "--allocs")
+        {
+#ifndef COUNT_ALLOCS
+            cout << "Error: --allocs needs the program built with"
+                 << " make mergesort_allocs\n";
+            return 1;
+#endif
+            allocs = true;
+        }
+        else if (arg == "--merge" && i + 2 < argc)
+        {
+            merge_files = {argv[i + 1], argv[i + 2]};
+            i += 2;
+        }
+        else
+        {
+            cout << "Usage: " << argv[0]
+                 << " [-j N | --msd | --adaptive | --prefix | --bench |"
+                 << " --external [-m MB] [--tmpdir DIR] | --top K]"
+                 << " [--unique | --count] [--allocs] < words.txt\n"
+                 << "       " << argv[0] << " [-j N] --merge A B\n";
+            return 1;
+        }
+    }
+
+    if (!merge_files.empty())
+    {
+        vector<string> a = read_sorted_words(merge_files[0]);
+        vector<string> b = read_sorted_words(merge_files[1]);
+        if (threads <= 0)
+            threads = cmpt::default_threads();
+        for (const string &w : cmpt::parallel_merge(a, b, threads))
+        {
+            cout << w << "\n";
+        }
+        return 0;
+    }
+
+    if (top > 0)
+    {
+        for (const string &w : cmpt::top_k(istream_iterator<string>(cin),
+                                           istream_iterator<string>(), top))
+        {
+            cout << w << "\n";
+        }
+        return 0;
+    }
+
+    if (external)
+    {
+        try
+        {
+            external_sort(cin, cout, size_t(max(1, memory_mb)) << 20, tmpdir);
+        }
+        catch (const runtime_error &e)
+        {
+            cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // read in the words from cin; when counting, the duplicates are removed
+    // as the words are read, so they're never all in memory at once
+    const bool counting = (unique || count) && !bench;
+    vector<string> words;
+    vector<int> counts;
+    long allocs_before = alloc_count;
+    if (counting)
+    {
+        read_unique(cin, words, counts);
+    }
+    else
+    {
+        string w;
+        while (cin >> w)
+        {
+            words.push_back(w);
+        }
+    }
+
+    if (bench)
+    {
+        do_bench(words);
+        return 0;
+    }
+
+    // sort them, unless read_unique already did
+    const int n = words.size();
+    if (!counting)
+    {
+        allocs_before = alloc_count;
+        if (msd)
+        {
+            cmpt::msd_radix_sort(words);
+        }
+        else if (adaptive)
+        {
+            adaptive_mergesort(words);
+        }
+        else if (prefix)
+        {
+            cmpt::prefix_key_sort(words);
+        }
+        else if (threads > 0)
+        {
+            parallel_mergesort(words, threads);
+        }
+        else
+        {
+            mergesort(words);
+        }
+    }
+    if (allocs)
+    {
+        cerr << "sorting " << n << " words allocated memory "
+             << alloc_count - allocs_before << " times\n";
+    }
 
-    // write them to cout
-    for (string w : words)
+    // write them to cout, in the same format as uniq -c if counting
+    for (int i = 0; i < words.size(); i++)
     {
-        cout << w << "\n";
+        if (count)
+            cout << setw(7) << counts[i] << " ";
+        cout << words[i] << "\n";
     }
 }
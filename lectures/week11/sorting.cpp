@@ -1,22 +1,34 @@
 // sorting.cpp
 
+#include "cmpt_algorithm.h"
+#include "cmpt_bench.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
 #include <vector>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
-// returns true if v is sorted from begin to end (not including end)
+// returns true if v is sorted from begin to end (not including end); uses the
+// generic version from cmpt_algorithm.h instead of its own loop
 bool is_sorted(const vector<int> &v, int begin, int end)
 {
-    for (int i = begin + 1; i < end; i++)
-    {
-        if (v[i - 1] > v[i])
-        {
-            return false;
-        }
-    }
-    return true;
+    return cmpt::generic_is_sorted(v.begin() + begin, v.begin() + end);
 }
 
 // returns true if v is in ascending sorted order,
@@ -26,7 +38,20 @@ bool is_sorted(const vector<int> &v)
     return is_sorted(v, 0, v.size());
 }
 
-long insertion_sort_comp_count = 0;
+// return a vector of n random ints
+vector<int> random_vector(int n)
+{
+    vector<int> result;
+    for (int i = 0; i < n; i++)
+    {
+        result.push_back(rand());
+    }
+    return result;
+}
+
+// thread_local so that threads sorting different parts of a vector at the
+// same time (see sample_sort) each count into their own copy
+thread_local long insertion_sort_comp_count = 0;
 
 void insertion_sort(vector<int> &v)
 {
@@ -106,6 +131,179 @@ void test_insertion_sort()
     cout << " ... test_insertion_sort done: all tests passed\n";
 }
 
+//
+// Sorting network
+//
+// A sorting network is a fixed sequence of compare-exchange steps, where each
+// step puts two positions in order. The steps are the same no matter what the
+// values are, so there are no unpredictable branches, and many steps can be
+// done at once. sort16 sorts exactly 16 ints using a bitonic sorting network.
+//
+// If the CPU supports AVX2 instructions, the 16 ints are kept in two 256-bit
+// registers (8 ints each) and each step does 8 compare-exchanges at once with
+// vector min and max instructions. Otherwise a plain C++ version of the same
+// network is used. The choice is made once, when the program starts.
+//
+
+const int sort_network_size = 16;
+
+// number of compare-exchanges in the 16-element bitonic network
+const int sort_network_comparisons = 80;
+
+// Sorts p[0] to p[15] using a bitonic network, one compare-exchange at a time.
+void sort16_scalar(int *p)
+{
+    for (int k = 2; k <= sort_network_size; k *= 2)
+    {
+        for (int j = k / 2; j > 0; j /= 2)
+        {
+            for (int i = 0; i < sort_network_size; i++)
+            {
+                int partner = i ^ j;
+                if (partner > i)
+                {
+                    // in this step the block containing i is sorted ascending
+                    // if (i & k) == 0, and descending otherwise
+                    int lo = min(p[i], p[partner]);
+                    int hi = max(p[i], p[partner]);
+                    bool ascending = (i & k) == 0;
+                    p[i] = ascending ? lo : hi;
+                    p[partner] = ascending ? hi : lo;
+                }
+            }
+        }
+    }
+} // sort16_scalar
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// One step of the network on the 8 ints in v: each int is compared with the
+// int at the position given by perm, and the lanes whose bit is set in
+// max_lanes keep the larger value while the others keep the smaller one.
+template <int max_lanes>
+__attribute__((target("avx2"))) __m256i compare_exchange8(__m256i v,
+                                                          __m256i perm)
+{
+    __m256i partner = _mm256_permutevar8x32_epi32(v, perm);
+    __m256i lo = _mm256_min_epi32(v, partner);
+    __m256i hi = _mm256_max_epi32(v, partner);
+    return _mm256_blend_epi32(lo, hi, max_lanes);
+}
+
+// Pre-condition:
+//    v is a bitonic sequence
+// Post-condition:
+//    v is sorted in ascending order
+__attribute__((target("avx2"))) __m256i bitonic_clean8(__m256i v)
+{
+    const __m256i xor4 = _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3);
+    const __m256i xor2 = _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5);
+    const __m256i xor1 = _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6);
+    v = compare_exchange8<0xF0>(v, xor4);
+    v = compare_exchange8<0xCC>(v, xor2);
+    v = compare_exchange8<0xAA>(v, xor1);
+    return v;
+}
+
+// sorts the 8 ints in v into ascending order
+__attribute__((target("avx2"))) __m256i sort8(__m256i v)
+{
+    const __m256i xor2 = _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5);
+    const __m256i xor1 = _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6);
+    v = compare_exchange8<0x66>(v, xor1); // sorted pairs, alternating up/down
+    v = compare_exchange8<0x3C>(v, xor2); // sorted 4s, alternating up/down
+    v = compare_exchange8<0x5A>(v, xor1);
+    return bitonic_clean8(v);             // v is bitonic, so clean it
+}
+
+// Sorts p[0] to p[15] using the same network as sort16_scalar, 8 ints at a
+// time.
+__attribute__((target("avx2"))) void sort16_avx2(int *p)
+{
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<__m256i *>(p));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<__m256i *>(p + 8));
+    a = sort8(a);
+    b = sort8(b);
+
+    // a ascending followed by b descending is bitonic, so after one step
+    // every int in lo is <= every int in hi, and both are bitonic
+    const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    b = _mm256_permutevar8x32_epi32(b, reverse);
+    __m256i lo = _mm256_min_epi32(a, b);
+    __m256i hi = _mm256_max_epi32(a, b);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), bitonic_clean8(lo));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p + 8), bitonic_clean8(hi));
+}
+
+#endif
+
+// returns the best version of sort16 that this CPU supports
+void (*choose_sort16())(int *)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2"))
+        return sort16_avx2;
+#endif
+    return sort16_scalar;
+}
+
+void (*const sort16)(int *) = choose_sort16();
+
+// Pre-condition:
+//    end - begin <= sort_network_size
+// Post-condition:
+//    v[begin] to v[end - 1] is in ascending sorted order
+//
+// Fewer than 16 ints are padded with the biggest int, which sorts to the end.
+void network_sort(vector<int> &v, int begin, int end)
+{
+    const int n = end - begin;
+    assert(n <= sort_network_size);
+    if (n <= 1)
+        return;
+
+    int block[sort_network_size];
+    for (int i = 0; i < sort_network_size; i++)
+    {
+        block[i] = i < n ? v[begin + i] : numeric_limits<int>::max();
+    }
+    sort16(block);
+    copy(block, block + n, v.begin() + begin);
+}
+
+void test_network_sort()
+{
+    cout << "Calling test_network_sort ...\n";
+    vector<void (*)(int *)> kernels = {sort16_scalar, sort16};
+    for (int t = 0; t < 2000; t++)
+    {
+        // random values, with lots of duplicates when t is odd
+        vector<int> v(sort_network_size);
+        for (int &x : v)
+        {
+            x = t % 2 == 0 ? rand() - RAND_MAX / 2 : rand() % 4;
+        }
+        vector<int> expected = v;
+        sort(expected.begin(), expected.end());
+
+        for (auto kernel : kernels)
+        {
+            vector<int> w = v;
+            kernel(w.data());
+            assert(w == expected);
+        }
+
+        // every size from 0 to 16, in the middle of a vector
+        int n = t % (sort_network_size + 1);
+        vector<int> u = v;
+        network_sort(u, 0, n);
+        assert(is_sorted(u, 0, n));
+        assert(equal(u.begin() + n, u.end(), v.begin() + n));
+    }
+    cout << " ... test_network_sort done: all tests passed\n";
+}
+
 //
 // Mergesort
 //
@@ -199,203 +397,1918 @@ void test_mergesort()
     cout << " ... test_mergesort done: all tests passed\n";
 }
 
-// return a vector of n random ints
-vector<int> random_vector(int n)
-{
-    vector<int> result;
-    for (int i = 0; i < n; i++)
-    {
-        result.push_back(rand());
-    }
-    return result;
-}
-
-void do_sort_test(int n)
-{
-    cout << "n = " << n << "\n";
-    cout << "# of comparisons\n";
-    cout << "Test  Insertion Sort  Mergesort\n";
-    long total_insertion_sort_comp_count = 0;
-    long total_mergesort_comp_count = 0;
-    for (int i = 0; i < 10; i++)
-    {
-        vector<int> a = random_vector(n);
-        vector<int> b = a;
-
-        insertion_sort_comp_count = 0;
-        insertion_sort(a);
-
-        mergesort_comp_count = 0;
-        mergesort(b);
-
-        int smaller = insertion_sort_comp_count / mergesort_comp_count;
-        cout << i << "     "
-             << insertion_sort_comp_count << "          "
-             << mergesort_comp_count
-             << " (" << smaller << " times smaller)\n";
-
-        total_insertion_sort_comp_count += insertion_sort_comp_count;
-        total_mergesort_comp_count += mergesort_comp_count;
-    } // for
-
-    int insertion_sort_avg = total_insertion_sort_comp_count / 10;
-    int mergesort_avg = total_mergesort_comp_count / 10;
-    cout << "\nAvg:  "
-         << insertion_sort_avg
-         << "          "
-         << mergesort_avg
-         << " (" << insertion_sort_avg / mergesort_avg << " times smaller)\n";
-} // do_sort_test
-
 //
-// Binary search
+// Buffered mergesort
 //
+// merge above copies all of v into result on every call, and then copies it
+// back, so sorting n elements does about n^2 copying. The functions below
+// allocate a single scratch vector for the whole sort and merge back and forth
+// between it and v.
+//
+
 // Pre-condition:
-//   v[begin] to v[end - 1] is in ascending sorted order
+//    is_sorted(in, begin, mid)
+//    is_sorted(in, mid, end)
 // Post-condition:
-//   returns an index i such that v[i] == x and
-//   begin <= i < end;
-//   if x is not found, -1 is returned
-int iterative_binary_search(int x, const vector<int> &v,
-                            int begin, int end)
+//    out[begin] to out[end - 1] contains the elements of in[begin] to
+//    in[end - 1] in ascending sorted order; in is not changed
+void merge_into(const vector<int> &in, vector<int> &out,
+                int begin, int mid, int end)
 {
-    while (begin < end)
+    int a = begin;
+    int b = mid;
+    for (int i = begin; i < end; i++)
     {
-        int mid = (begin + end) / 2;
-        if (v[mid] == x)
-        { // found x!
-            return mid;
+        if (a >= mid)
+        {
+            mergesort_comp_count += 1;
+            out[i] = in[b];
+            b++;
         }
-        else if (x < v[mid])
+        else if (b >= end)
         {
-            end = mid;
+            mergesort_comp_count += 2;
+            out[i] = in[a];
+            a++;
         }
-        else // x > v[mid]
+        else if (in[a] < in[b])
         {
-            begin = mid + 1;
+            mergesort_comp_count += 3;
+            out[i] = in[a];
+            a++;
         }
-    }
-    return -1; // x not found
-}
+        else
+        {
+            out[i] = in[b];
+            b++;
+        }
+    } // for
+} // merge_into
 
 // Pre-condition:
-//    v is in ascending sorted order
+//    src[begin] to src[end - 1] is the same as dst[begin] to dst[end - 1]
 // Post-condition:
-//    returns an index i such that v[i] == x; if x is
-//    not in v, -1 is returned
-int iterative_binary_search(int x, const vector<int> &v)
+//    dst[begin] to dst[end - 1] is in ascending sorted order; src[begin] to
+//    src[end - 1] has been used as scratch space
+//
+// Each level of the recursion swaps the roles of src and dst, so no elements
+// are ever copied except by merge_into.
+void sort_into(vector<int> &src, vector<int> &dst, int begin, int end)
 {
-    return iterative_binary_search(x, v, 0, v.size());
+    const int n = end - begin;
+    if (n <= 1)
+        return; // base case: dst already holds the element
+
+    int mid = (begin + end) / 2;
+    sort_into(dst, src, begin, mid); // sort the left half into src
+    sort_into(dst, src, mid, end);   // sort the right half into src
+    merge_into(src, dst, begin, mid, end);
 }
 
-void test_iterative_binary_search()
+// top-down mergesort that allocates only one scratch vector
+void mergesort_buffered(vector<int> &v)
 {
-    cout << "Calling test_iterative_binary_search ...\n";
-    vector<int> empty = {};
-    vector<int> one = {5};
-    vector<int> two = {2, 7};
-    vector<int> three = {2, 5, 7};
-
-    assert(iterative_binary_search(5, empty) == -1);
-    assert(iterative_binary_search(5, one) == 0);
-    assert(iterative_binary_search(2, one) == -1);
-
-    assert(iterative_binary_search(2, two) == 0);
-    assert(iterative_binary_search(7, two) == 1);
-    assert(iterative_binary_search(1, two) == -1);
-    assert(iterative_binary_search(5, two) == -1);
-    assert(iterative_binary_search(10, two) == -1);
-
-    assert(iterative_binary_search(2, three) == 0);
-    assert(iterative_binary_search(5, three) == 1);
-    assert(iterative_binary_search(7, three) == 2);
-    assert(iterative_binary_search(1, three) == -1);
-    assert(iterative_binary_search(3, three) == -1);
-    assert(iterative_binary_search(6, three) == -1);
-    assert(iterative_binary_search(10, three) == -1);
-
-    cout << "... test_iterative_binary_search done: all tests passed\n";
+    vector<int> scratch(v);
+    sort_into(scratch, v, 0, v.size());
+    assert(is_sorted(v));
 }
 
-int recursive_binary_search(int x, const vector<int> &v,
-                            int begin, int end)
+// Bottom-up (iterative) mergesort: first sort blocks of 16 elements with the
+// sorting network, then merge pairs of 16-element runs, then pairs of
+// 32-element runs, and so on. Each pass merges all of one vector into the
+// other, so after the last pass the sorted result may be in the scratch
+// vector, in which case the two are swapped.
+void mergesort_bottom_up(vector<int> &v)
 {
-    const int n = end - begin;
-
-    // if the sub-vector being searched is empty,
-    // then x is not in it
-    if (n <= 0)
-        return -1; // x not found
-
-    int mid = (begin + end) / 2;
-    if (x == v[mid])
+    const int n = v.size();
+    for (int begin = 0; begin < n; begin += sort_network_size)
     {
-        return mid;
+        mergesort_comp_count += sort_network_comparisons;
+        network_sort(v, begin, min(begin + sort_network_size, n));
     }
-    else if (x < v[mid])
+
+    vector<int> scratch(n);
+    vector<int> *src = &v;
+    vector<int> *dst = &scratch;
+    for (int width = sort_network_size; width < n; width *= 2)
     {
-        return recursive_binary_search(x, v, begin, mid);
+        for (int begin = 0; begin < n; begin += 2 * width)
+        {
+            int mid = min(begin + width, n);
+            int end = min(begin + 2 * width, n);
+            merge_into(*src, *dst, begin, mid, end);
+        }
+        swap(src, dst);
     }
-    else
+
+    // after the final pass the sorted elements are in *src
+    if (src != &v)
     {
-        return recursive_binary_search(x, v, mid + 1, end);
+        v.swap(scratch);
     }
+    assert(is_sorted(v));
+} // mergesort_bottom_up
+
+bool mergesort_buffered_ok(vector<int> v)
+{
+    mergesort_buffered(v);
+    return is_sorted(v);
 }
 
-// Pre-condition:
-//    v is in ascending sorted order
-// Post-condition:
-//    returns an index i such that v[i] == x;
-//    if x is not in v, -1 is returned
-int recursive_binary_search(int x, const vector<int> &v)
+bool mergesort_bottom_up_ok(vector<int> v)
 {
-    return recursive_binary_search(x, v, 0, v.size());
+    mergesort_bottom_up(v);
+    return is_sorted(v);
 }
 
-void test_recursive_binary_search()
+void test_mergesort_buffered()
 {
-    cout << "Calling test_recursive_binary_search ...\n";
+    cout << "Calling test_mergesort_buffered ...\n";
     vector<int> empty = {};
     vector<int> one = {5};
-    vector<int> two = {2, 7};
-    vector<int> three = {2, 5, 7};
+    vector<int> two_a = {2, 7};
+    vector<int> two_b = {4, 1};
+    vector<int> two_c = {3, 3};
+    vector<int> same = {4, 4, 4, 4, 4, 4};
+    vector<int> ordered = {-1, 0, 5, 9, 10};
+    vector<int> rev = {8, 7, 3, 1, 0, -5};
+    vector<int> odd = {6, -2, 9, 9, 0, 4, 1};
 
-    assert(recursive_binary_search(5, empty) == -1);
-    
-    assert(recursive_binary_search(5, one) == 0);
-    assert(recursive_binary_search(2, one) == -1);
+    for (vector<int> v : {empty, one, two_a, two_b, two_c,
+                          same, ordered, rev, odd})
+    {
+        assert(mergesort_buffered_ok(v));
+        assert(mergesort_bottom_up_ok(v));
+    }
+    cout << " ... test_mergesort_buffered done: all tests passed\n";
+}
 
-    assert(recursive_binary_search(2, two) == 0);
-    assert(recursive_binary_search(7, two) == 1);
-    assert(recursive_binary_search(1, two) == -1);
-    assert(recursive_binary_search(5, two) == -1);
-    assert(recursive_binary_search(10, two) == -1);
+//
+// Binary insertion sort
+//
+// insertion_sort finds where to put each key by checking the sorted part one
+// element at a time, and moves the elements one at a time as it goes. For
+// small and medium vectors it's faster to find the insertion point with binary
+// search, and then shift all the elements after it up one position with a
+// single block move (copy_backward), which the compiler turns into a memmove.
+//
 
-    assert(recursive_binary_search(2, three) == 0);
-    assert(recursive_binary_search(5, three) == 1);
-    assert(recursive_binary_search(7, three) == 2);
-    assert(recursive_binary_search(1, three) == -1);
-    assert(recursive_binary_search(3, three) == -1);
-    assert(recursive_binary_search(6, three) == -1);
-    assert(recursive_binary_search(10, three) == -1);
+// Pre-condition:
+//    0 <= begin <= end <= v.size()
+// Post-condition:
+//    v[begin] to v[end - 1] is in ascending sorted order
+void binary_insertion_sort(vector<int> &v, int begin, int end)
+{
+    for (int i = begin + 1; i < end; i++)
+    {
+        int key = v[i];
 
-    cout << "... test_recursive_binary_search done: all tests passed\n";
+        // binary search for the first position in v[begin] to v[i - 1] whose
+        // value is bigger than key; inserting key there keeps equal values in
+        // their original order
+        int lo = begin;
+        int hi = i;
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            insertion_sort_comp_count++;
+            if (key < v[mid])
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+
+        // shift v[lo] to v[i - 1] up one position, then insert key
+        copy_backward(v.begin() + lo, v.begin() + i, v.begin() + i + 1);
+        v[lo] = key;
+    }
+} // binary_insertion_sort
+
+void binary_insertion_sort(vector<int> &v)
+{
+    binary_insertion_sort(v, 0, v.size());
+    assert(is_sorted(v));
 }
 
-// int main()
-int main(int argc, char *argv[])
+// Pre-condition:
+//    there is some j < i such that v[j] <= v[i], and v[j] to v[i - 1] is
+//    in ascending sorted order
+// Post-condition:
+//    v[i] has been inserted into its place in the sorted part
+//
+// The pre-condition guarantees the loop stops before it runs off the start of
+// the sorted part, so unlike in insertion_sort the loop doesn't need to check
+// j >= 0. This is called an unguarded loop.
+void unguarded_linear_insert(vector<int> &v, int i)
 {
-    if (argc != 2)
+    int key = v[i];
+    int j = i - 1;
+    while (key < v[j])
     {
-        cout << "Usage: " << argv[0] << " n\n";
+        insertion_sort_comp_count++;
+        v[j + 1] = v[j];
+        j--;
+    }
+    v[j + 1] = key;
+}
+
+// Insertion sort of v[begin] to v[end - 1] using the unguarded inner loop.
+//
+// The only key that could run off the start of the sorted part is one that is
+// smaller than v[begin], i.e. a new minimum. That is checked for once (the
+// guard), and a new minimum is put at the front with a block move. Every other
+// key has v[begin] <= key, so it can use the unguarded loop.
+void guarded_insertion_sort(vector<int> &v, int begin, int end)
+{
+    for (int i = begin + 1; i < end; i++)
+    {
+        insertion_sort_comp_count++;
+        if (v[i] < v[begin])
+        {
+            int key = v[i];
+            copy_backward(v.begin() + begin, v.begin() + i, v.begin() + i + 1);
+            v[begin] = key;
+        }
+        else
+        {
+            unguarded_linear_insert(v, i);
+        }
+    }
+} // guarded_insertion_sort
+
+void guarded_insertion_sort(vector<int> &v)
+{
+    guarded_insertion_sort(v, 0, v.size());
+    assert(is_sorted(v));
+}
+
+//
+// Hybrid mergesort
+//
+// For small n insertion sort is faster than mergesort, since it has less
+// overhead. So the hybrid mergesort uses binary insertion sort for
+// sub-vectors with fewer than insertion_sort_cutoff elements. Other
+// sub-vectors of 16 or fewer elements are sorted with the sorting network,
+// and bigger ones are merged (like mergesort_buffered).
+//
+// The network takes the same time for any length up to 16, so insertion sort
+// is only faster for the shortest sub-vectors. If the cutoff is above 16 the
+// network is never used.
+//
+
+const int default_insertion_sort_cutoff = 5;
+int insertion_sort_cutoff = default_insertion_sort_cutoff;
+
+// Same as sort_into, but sub-vectors smaller than insertion_sort_cutoff are
+// sorted by binary insertion sort, and other sub-vectors that are small enough
+// by network_sort.
+void hybrid_sort_into(vector<int> &src, vector<int> &dst, int begin, int end)
+{
+    const int n = end - begin;
+    if (n < insertion_sort_cutoff)
+    {
+        binary_insertion_sort(dst, begin, end);
+        return;
+    }
+    if (n <= sort_network_size)
+    {
+        mergesort_comp_count += sort_network_comparisons;
+        network_sort(dst, begin, end);
+        return;
+    }
+
+    int mid = (begin + end) / 2;
+    hybrid_sort_into(dst, src, begin, mid);
+    hybrid_sort_into(dst, src, mid, end);
+    merge_into(src, dst, begin, mid, end);
+}
+
+void mergesort_hybrid(vector<int> &v)
+{
+    long insertion_comps_before = insertion_sort_comp_count;
+    vector<int> scratch(v);
+    hybrid_sort_into(scratch, v, 0, v.size());
+
+    // count the comparisons done by insertion sort as mergesort comparisons
+    mergesort_comp_count += insertion_sort_comp_count - insertion_comps_before;
+    insertion_sort_comp_count = insertion_comps_before;
+    assert(is_sorted(v));
+}
+
+//
+// Calibrating the hybrid cutoff
+//
+// The best insertion_sort_cutoff depends on the computer (and the compiler
+// options), so instead of guessing it can be measured. ./sorting --calibrate
+// times, for bigger and bigger n, binary insertion sort against what
+// hybrid_sort_into does when it doesn't use insertion sort for length n: the
+// sorting network if n <= sort_network_size, and otherwise splitting in half
+// and merging. The first n for which insertion sort is slower is saved in
+// sorting_config_file, which main reads every time it starts.
+//
+
+// Cutoffs less than this are never used: insertion sort is always at least as
+// fast as anything else on 0 or 1 elements.
+const int min_insertion_sort_cutoff = 2;
+
+// Name of the config file. main sets it to sorting.cfg in the same directory
+// as the program, so the program finds it no matter where it's run from.
+string sorting_config_file = "sorting.cfg";
+
+// Returns the smallest n for which binary insertion sort is slower than
+// hybrid_sort_into with insertion_sort_cutoff set to n, on random vectors of
+// length n.
+int measure_insertion_cutoff()
+{
+    // each timing sorts many vectors of length n, all stored one after the
+    // other in v, so it takes long enough to measure accurately
+    const int total = 1 << 16;
+    const vector<int> data = random_vector(total);
+    vector<int> v;
+    vector<int> scratch;
+
+    const int saved_cutoff = insertion_sort_cutoff;
+    cmpt::Bench bench(5, 1);
+    int n = min_insertion_sort_cutoff;
+    while (n < 1024)
+    {
+        double insertion_ms = bench.run(
+            "Binary insertion sort", n,
+            [&]() { v = data; },
+            [&]()
+            {
+                for (int b = 0; b + n <= total; b += n)
+                    binary_insertion_sort(v, b, b + n);
+            }).median();
+
+        // with cutoff n, length n is sorted by the network or by splitting,
+        // and anything shorter by insertion sort
+        insertion_sort_cutoff = n;
+        double hybrid_ms = bench.run(
+            "Hybrid without insertion sort", n,
+            [&]() { v = data; scratch = data; },
+            [&]()
+            {
+                for (int b = 0; b + n <= total; b += n)
+                    hybrid_sort_into(scratch, v, b, b + n);
+            }).median();
+        insertion_sort_cutoff = saved_cutoff;
+        if (hybrid_ms < insertion_ms)
+            break;
+        n += max(1, n / 8);
+    }
+    return n;
+} // measure_insertion_cutoff
+
+// Sets insertion_sort_cutoff from the config file, if there is one. Each line
+// of the file is a name, =, and a value, e.g. "insertion_sort_cutoff = 40".
+// Values less than min_insertion_sort_cutoff are ignored.
+void load_sorting_config()
+{
+    ifstream in(sorting_config_file);
+    string name;
+    string equals;
+    int value;
+    while (in >> name >> equals >> value)
+    {
+        if (name == "insertion_sort_cutoff" && equals == "=" &&
+            value >= min_insertion_sort_cutoff)
+            insertion_sort_cutoff = value;
+    }
+}
+
+void save_sorting_config()
+{
+    ofstream out(sorting_config_file);
+    out << "insertion_sort_cutoff = " << insertion_sort_cutoff << "\n";
+}
+
+void test_binary_insertion_sort()
+{
+    cout << "Calling test_binary_insertion_sort ...\n";
+    vector<vector<int>> tests = {
+        {},
+        {5},
+        {2, 7},
+        {4, 1},
+        {3, 3},
+        {4, 4, 4, 4, 4, 4},
+        {-1, 0, 5, 9, 10},
+        {8, 7, 3, 1, 0, -5},
+        {6, -2, 9, 9, 0, 4, 1},
+    };
+    tests.push_back(random_vector(1000));
+
+    for (vector<int> v : tests)
+    {
+        vector<int> a = v;
+        binary_insertion_sort(a);
+        assert(is_sorted(a));
+
+        vector<int> b = v;
+        guarded_insertion_sort(b);
+        assert(b == a);
+
+        // try different cutoffs so the merging code is used too
+        for (int cutoff : {1, 2, 5, 16, 17, 40, 2000})
+        {
+            insertion_sort_cutoff = cutoff;
+            vector<int> c = v;
+            mergesort_hybrid(c);
+            assert(c == a);
+        }
+        insertion_sort_cutoff = default_insertion_sort_cutoff;
+    }
+
+    // sorting part of a vector doesn't change the rest
+    vector<int> v = {9, 8, 7, 6, 5, 4};
+    binary_insertion_sort(v, 1, 4);
+    assert(v == vector<int>({9, 6, 7, 8, 5, 4}));
+    v = {9, 8, 7, 6, 5, 4};
+    guarded_insertion_sort(v, 1, 4);
+    assert(v == vector<int>({9, 6, 7, 8, 5, 4}));
+
+    cout << " ... test_binary_insertion_sort done: all tests passed\n";
+}
+
+//
+// Parallel mergesort
+//
+// The two halves are sorted at the same time by different threads, and then
+// merged with cmpt::parallel_merge, which splits the merge into independent
+// pieces so that the final merge uses all the threads too.
+//
+// The mergesort comparison counter is a global variable, and so it isn't safe
+// for several threads to change it at the same time. Thus the parallel sort
+// doesn't count comparisons, and uses cmpt::mergesort for the parts that are
+// sorted by one thread.
+//
+
+// number of threads used by mergesort_parallel
+int sort_threads = cmpt::default_threads();
+
+// Same as sort_into, but uses up to threads threads.
+void parallel_sort_into(vector<int> &src, vector<int> &dst,
+                        int begin, int end, int threads)
+{
+    const int n = end - begin;
+    if (threads <= 1 || n < (1 << 15))
+    {
+        cmpt::mergesort(dst.begin() + begin, dst.begin() + end);
+        return;
+    }
+
+    int mid = (begin + end) / 2;
+    int left_threads = threads / 2;
+    thread left(parallel_sort_into, ref(dst), ref(src), begin, mid,
+                left_threads);
+    parallel_sort_into(dst, src, mid, end, threads - left_threads);
+    left.join();
+
+    cmpt::parallel_merge(src.begin() + begin, src.begin() + mid,
+                         src.begin() + mid, src.begin() + end,
+                         dst.begin() + begin, threads);
+}
+
+void mergesort_parallel(vector<int> &v)
+{
+    vector<int> scratch(v);
+    parallel_sort_into(scratch, v, 0, v.size(), sort_threads);
+    assert(is_sorted(v));
+}
+
+void test_mergesort_parallel()
+{
+    cout << "Calling test_mergesort_parallel ...\n";
+    vector<int> big = random_vector(200000);
+    vector<int> expected = big;
+    mergesort_buffered(expected);
+    for (int threads = 1; threads <= 8; threads++)
+    {
+        sort_threads = threads;
+        vector<int> v = big;
+        mergesort_parallel(v);
+        assert(v == expected);
+    }
+    sort_threads = cmpt::default_threads();
+
+    // parallel_merge must be stable: sort pairs by first only, and check that
+    // equal firsts keep the order of the second
+    vector<pair<int, int>> a;
+    vector<pair<int, int>> b;
+    for (int i = 0; i < 100000; i++)
+    {
+        a.push_back({i / 3, 0});
+        b.push_back({i / 5, 1});
+    }
+    auto by_first = [](const pair<int, int> &x, const pair<int, int> &y)
+    { return x.first < y.first; };
+    vector<pair<int, int>> merged(a.size() + b.size());
+    merge(a.begin(), a.end(), b.begin(), b.end(), merged.begin(), by_first);
+    for (int threads = 1; threads <= 8; threads++)
+    {
+        assert(cmpt::parallel_merge(a, b, threads, by_first) == merged);
+    }
+
+    // one or both ranges empty
+    vector<int> empty;
+    vector<int> some = {1, 2, 3};
+    assert(cmpt::parallel_merge(empty, empty, 4).empty());
+    assert(cmpt::parallel_merge(empty, some, 4) == some);
+    assert(cmpt::parallel_merge(some, empty, 4) == some);
+
+    cout << " ... test_mergesort_parallel done: all tests passed\n";
+}
+
+//
+// LSD radix sort
+//
+// Radix sort doesn't compare elements at all. Instead, it treats each int as 4
+// digits of 8 bits each, and sorts by the least significant digit first, then
+// the next digit, and so on. Each pass is a stable counting sort, and so after
+// the last pass v is sorted by all 4 digits.
+//
+// An int's bits put negative numbers after positive ones (the sign bit is 1
+// for negatives), so the sign bit is flipped when the most significant digit is
+// read.
+//
+
+long radix_sort_op_count = 0;
+
+const int radix_bits = 8;
+const int radix_size = 1 << radix_bits; // number of different digits
+const int radix_passes = 32 / radix_bits;
+
+// returns digit number pass of x, where digit 0 is the least significant
+int radix_digit(int x, int pass)
+{
+    // flip the sign bit, so negative numbers come before positive ones
+    unsigned int u = static_cast<unsigned int>(x) ^ 0x80000000u;
+    return (u >> (pass * radix_bits)) & (radix_size - 1);
+}
+
+void radix_sort(vector<int> &v)
+{
+    const int n = v.size();
+    if (n <= sort_network_size)
+    {
+        radix_sort_op_count += sort_network_comparisons;
+        network_sort(v, 0, n);
+        return;
+    }
+
+    vector<int> scratch(n);
+
+    // count[pass][d] is the number of elements whose digit number pass is d;
+    // all the counts are done in one pass through v
+    vector<vector<int>> count(radix_passes, vector<int>(radix_size, 0));
+    for (int x : v)
+    {
+        radix_sort_op_count++;
+        for (int pass = 0; pass < radix_passes; pass++)
+        {
+            count[pass][radix_digit(x, pass)]++;
+        }
+    }
+
+    vector<int> *src = &v;
+    vector<int> *dst = &scratch;
+    for (int pass = 0; pass < radix_passes; pass++)
+    {
+        // if every element has the same digit this pass wouldn't change
+        // anything, so skip it
+        if (n == 0 || count[pass][radix_digit(v[0], pass)] == n)
+            continue;
+
+        // start[d] is where the first element with digit d goes
+        vector<int> start(radix_size, 0);
+        for (int d = 1; d < radix_size; d++)
+        {
+            start[d] = start[d - 1] + count[pass][d - 1];
+        }
+
+        for (int x : *src)
+        {
+            radix_sort_op_count++;
+            (*dst)[start[radix_digit(x, pass)]++] = x;
+        }
+        swap(src, dst);
+    } // for
+
+    // after the final pass the sorted elements are in *src
+    if (src != &v)
+    {
+        v.swap(scratch);
+    }
+    assert(is_sorted(v));
+} // radix_sort
+
+bool radix_sort_ok(vector<int> v)
+{
+    radix_sort(v);
+    return is_sorted(v);
+}
+
+void test_radix_sort()
+{
+    cout << "Calling test_radix_sort ...\n";
+    vector<int> empty = {};
+    vector<int> one = {5};
+    vector<int> two_a = {2, 7};
+    vector<int> two_b = {4, 1};
+    vector<int> two_c = {3, 3};
+    vector<int> same = {4, 4, 4, 4, 4, 4};
+    vector<int> ordered = {-1, 0, 5, 9, 10};
+    vector<int> rev = {8, 7, 3, 1, 0, -5};
+    vector<int> extremes = {0, 2147483647, -2147483647 - 1, -1, 1, 256, -256};
+
+    assert(radix_sort_ok(empty));
+    assert(radix_sort_ok(one));
+    assert(radix_sort_ok(two_a));
+    assert(radix_sort_ok(two_b));
+    assert(radix_sort_ok(two_c));
+    assert(radix_sort_ok(same));
+    assert(radix_sort_ok(ordered));
+    assert(radix_sort_ok(rev));
+    assert(radix_sort_ok(extremes));
+    cout << " ... test_radix_sort done: all tests passed\n";
+}
+
+//
+// Selection and top-k
+//
+// Often only part of the sorted order is needed, e.g. the smallest k values,
+// or the median. Those can be found faster than by sorting everything.
+//
+
+// Pre-condition:
+//    0 <= k <= v.size()
+// Post-condition:
+//    v[0] to v[k - 1] are the k smallest values of v, in ascending order; the
+//    rest of v is in no particular order
+//
+// v[0] to v[k - 1] are kept as a max-heap of the smallest values seen so far,
+// so v[0] is the biggest of them. Every later value smaller than v[0] is
+// swapped with it. This takes O(n log k) time.
+void partial_sort(vector<int> &v, int k)
+{
+    if (k <= 0)
+        return;
+
+    auto heap_end = v.begin() + k;
+    make_heap(v.begin(), heap_end);
+    for (int i = k; i < v.size(); i++)
+    {
+        if (v[i] < v[0])
+        {
+            pop_heap(v.begin(), heap_end); // moves the biggest to v[k - 1]
+            swap(v[k - 1], v[i]);
+            push_heap(v.begin(), heap_end);
+        }
+    }
+    sort_heap(v.begin(), heap_end);
+}
+
+// returns the k smallest values of v in ascending order
+vector<int> top_k(const vector<int> &v, int k)
+{
+    return cmpt::top_k(v.begin(), v.end(), k);
+}
+
+// Rearranges v[begin] to v[end - 1] into three parts: values less than pivot,
+// then values equal to pivot, then values greater than pivot. Returns the
+// index of the first equal value and the index just after the last one.
+pair<int, int> partition3(vector<int> &v, int begin, int end, int pivot)
+{
+    int lt = begin; // v[begin] to v[lt - 1] are < pivot
+    int i = begin;  // v[lt] to v[i - 1] are == pivot
+    int gt = end;   // v[gt] to v[end - 1] are > pivot
+    while (i < gt)
+    {
+        if (v[i] < pivot)
+        {
+            swap(v[lt], v[i]);
+            lt++;
+            i++;
+        }
+        else if (pivot < v[i])
+        {
+            gt--;
+            swap(v[i], v[gt]);
+        }
+        else
+        {
+            i++;
+        }
+    }
+    return {lt, gt};
+}
+
+void introselect(vector<int> &v, int k);
+
+// Returns the median of the medians of groups of 5 values of v[begin] to
+// v[end - 1]. At least 30% of the values are <= it and at least 30% are >= it,
+// so it's always a good enough pivot.
+int median_of_medians(const vector<int> &v, int begin, int end)
+{
+    vector<int> medians;
+    for (int i = begin; i < end; i += 5)
+    {
+        vector<int> group(v.begin() + i, v.begin() + min(i + 5, end));
+        insertion_sort(group);
+        medians.push_back(group[group.size() / 2]);
+    }
+    int m = medians.size() / 2;
+    introselect(medians, m);
+    return medians[m];
+}
+
+// Pre-condition:
+//    0 <= k < v.size()
+// Post-condition:
+//    v[k] is the value that would be there if v were sorted, every value
+//    before it is <= v[k], and every value after it is >= v[k]
+//
+// Quickselect partitions v around a pivot like quicksort, but then only
+// continues with the part that contains index k, so on average it takes
+// linear time. Bad pivots can make quickselect take quadratic time, so if it
+// partitions more than 2 * log2(n) times without finishing, introselect
+// switches to median-of-medians pivots, which guarantee linear time.
+void introselect(vector<int> &v, int k)
+{
+    int begin = 0;
+    int end = v.size();
+    int partitions_left = 2 * log2(max(2, end));
+    while (end - begin > sort_network_size)
+    {
+        int pivot;
+        if (partitions_left > 0)
+        {
+            // median of the first, middle and last values
+            int a = v[begin];
+            int b = v[(begin + end) / 2];
+            int c = v[end - 1];
+            pivot = max(min(a, b), min(max(a, b), c));
+            partitions_left--;
+        }
+        else
+        {
+            pivot = median_of_medians(v, begin, end);
+        }
+
+        pair<int, int> equal = partition3(v, begin, end, pivot);
+        if (k < equal.first)
+            end = equal.first;
+        else if (k >= equal.second)
+            begin = equal.second;
+        else
+            return; // v[k] is equal to the pivot, which is in its place
+    }
+    network_sort(v, begin, end);
+} // introselect
+
+// returns the median of v, i.e. the value in the middle when v is sorted (for
+// an even number of values, the larger of the two middle values)
+int median(vector<int> v)
+{
+    assert(!v.empty());
+    int mid = v.size() / 2;
+    introselect(v, mid);
+    return v[mid];
+}
+
+void test_selection()
+{
+    cout << "Calling test_selection ...\n";
+    vector<vector<int>> tests = {
+        {5},
+        {4, 1},
+        {4, 4, 4, 4, 4, 4},
+        {8, 7, 3, 1, 0, -5},
+        {6, -2, 9, 9, 0, 4, 1},
+    };
+    tests.push_back(random_vector(1000));
+    vector<int> dups;
+    for (int i = 0; i < 1000; i++)
+    {
+        dups.push_back(rand() % 10);
+    }
+    tests.push_back(dups);
+
+    // an increasing sequence, then a decreasing one: bad for median-of-3
+    vector<int> organ_pipe;
+    for (int i = 0; i < 1000; i++)
+    {
+        organ_pipe.push_back(i < 500 ? i : 1000 - i);
+    }
+    tests.push_back(organ_pipe);
+
+    for (const vector<int> &v : tests)
+    {
+        vector<int> sorted = v;
+        insertion_sort(sorted);
+        const int n = v.size();
+        for (int k : {0, 1, n / 3, n / 2, n - 1, n})
+        {
+            k = min(k, n);
+            vector<int> expected(sorted.begin(), sorted.begin() + k);
+
+            vector<int> a = v;
+            partial_sort(a, k);
+            assert(vector<int>(a.begin(), a.begin() + k) == expected);
+
+            assert(top_k(v, k) == expected);
+
+            if (k < n)
+            {
+                vector<int> b = v;
+                introselect(b, k);
+                assert(b[k] == sorted[k]);
+                for (int i = 0; i < n; i++)
+                {
+                    assert(i <= k ? b[i] <= b[k] : b[i] >= b[k]);
+                }
+            }
+        }
+        assert(median(v) == sorted[n / 2]);
+    }
+    cout << " ... test_selection done: all tests passed\n";
+}
+
+//
+// Pattern-defeating quicksort
+//
+// Quicksort partitions v around a pivot, so that smaller values come before it
+// and bigger values after it, and then sorts the two parts recursively. It's
+// usually the fastest comparison sort, but a bad pivot every time makes it take
+// O(n^2) time. pdqsort (pattern-defeating quicksort, by Orson Peters) is
+// quicksort with these changes:
+//
+// - The pivot is the median of 3 values, or for big ranges the median of 3
+//   medians of 3 (the ninther), so it's rarely bad.
+// - Partitioning is done in blocks: first the positions of up to 64 values
+//   that are on the wrong side are recorded, without any if statements, and
+//   then they are swapped. Branches that the CPU can't predict are slow, and
+//   with a random pivot "is this value on the wrong side?" is a coin flip.
+// - If a partition is very unbalanced, some values are swapped around to break
+//   up whatever pattern caused it. If that happens log2(n) times, the range is
+//   sorted with heapsort instead, which guarantees O(n log n) time.
+// - If a partition didn't need to swap anything, the range may already be
+//   sorted, so insertion sort is tried on both parts. It gives up after a few
+//   moves, so it's cheap when the guess is wrong.
+// - If the pivot equals the value just before the range, then the range has
+//   many values equal to the pivot, and they are all put in place at once.
+//
+
+thread_local long quicksort_comp_count = 0;
+
+// Ranges smaller than this are sorted with insertion sort.
+const int quicksort_insertion_cutoff = 24;
+
+// Ranges bigger than this use the ninther as the pivot.
+const int quicksort_ninther_cutoff = 128;
+
+// Number of values looked at from each side in one step of the block partition.
+const int partition_block_size = 64;
+
+// partial_insertion_sort gives up after this many moves.
+const int partial_insertion_limit = 8;
+
+// Sorts v[begin] to v[end - 1] with heapsort.
+void heapsort(vector<int> &v, int begin, int end)
+{
+    auto less = [](int a, int b)
+    {
+        quicksort_comp_count++;
+        return a < b;
+    };
+    make_heap(v.begin() + begin, v.begin() + end, less);
+    sort_heap(v.begin() + begin, v.begin() + end, less);
+}
+
+// Swaps values so that v[a] <= v[b] <= v[c].
+void sort3(vector<int> &v, int a, int b, int c)
+{
+    quicksort_comp_count += 3;
+    if (v[b] < v[a])
+        swap(v[a], v[b]);
+    if (v[c] < v[b])
+        swap(v[b], v[c]);
+    if (v[b] < v[a])
+        swap(v[a], v[b]);
+}
+
+// Moves the pivot for v[begin] to v[end - 1] into v[begin].
+void choose_pivot(vector<int> &v, int begin, int end)
+{
+    const int n = end - begin;
+    const int mid = begin + n / 2;
+    if (n > quicksort_ninther_cutoff)
+    {
+        sort3(v, begin, mid, end - 1);
+        sort3(v, begin + 1, mid - 1, end - 2);
+        sort3(v, begin + 2, mid + 1, end - 3);
+        sort3(v, mid - 1, mid, mid + 1);
+        swap(v[begin], v[mid]);
+    }
+    else
+    {
+        sort3(v, mid, begin, end - 1);
+    }
+}
+
+// Pre-condition:
+//    the pivot is in v[begin], and v[end - 1] >= pivot (choose_pivot ensures
+//    it)
+// Post-condition:
+//    returns the final index p of the pivot; v[begin] to v[p - 1] are < pivot
+//    and v[p + 1] to v[end - 1] are >= pivot; already_partitioned is set to
+//    true if no values had to be swapped
+int partition_right(vector<int> &v, int begin, int end,
+                    bool &already_partitioned)
+{
+    const int pivot = v[begin];
+    int first = begin;
+    int last = end;
+
+    // skip values already on the correct side; the loops stop at v[end - 1]
+    // and v[begin], so they don't need to check first < last except when
+    // nothing was skipped on the left
+    do
+    {
+        first++;
+        quicksort_comp_count++;
+    } while (v[first] < pivot);
+    if (first - 1 == begin)
+    {
+        while (first < last)
+        {
+            last--;
+            quicksort_comp_count++;
+            if (v[last] < pivot)
+                break;
+        }
+    }
+    else
+    {
+        do
+        {
+            last--;
+            quicksort_comp_count++;
+        } while (!(v[last] < pivot));
+    }
+
+    already_partitioned = first >= last;
+    if (!already_partitioned)
+    {
+        swap(v[first], v[last]);
+        first++;
+
+        // offsets_l holds offsets from left_base of values >= pivot on the
+        // left, and offsets_r holds offsets back from right_base of values
+        // < pivot on the right
+        unsigned char offsets_l[partition_block_size];
+        unsigned char offsets_r[partition_block_size];
+        int left_base = first;
+        int right_base = last;
+        int num_l = 0;
+        int num_r = 0;
+        int start_l = 0;
+        int start_r = 0;
+        while (first < last)
+        {
+            // only scan a side once all its offsets have been used up
+            const int unknown = last - first;
+            int left_split = 0;
+            if (num_l == 0)
+                left_split = num_r == 0 ? unknown / 2 : unknown;
+            const int right_split = num_r == 0 ? unknown - left_split : 0;
+
+            // no if statements here: the offset is always written, and the
+            // count only goes up if the value is on the wrong side
+            const int left_n = min(left_split, partition_block_size);
+            for (int i = 0; i < left_n; i++)
+            {
+                offsets_l[num_l] = i;
+                num_l += !(v[first] < pivot);
+                first++;
+            }
+            const int right_n = min(right_split, partition_block_size);
+            for (int i = 1; i <= right_n; i++)
+            {
+                last--;
+                offsets_r[num_r] = i;
+                num_r += v[last] < pivot;
+            }
+            quicksort_comp_count += left_n + right_n;
+
+            // swap pairs of values that are both on the wrong side
+            const int num = min(num_l, num_r);
+            for (int i = 0; i < num; i++)
+            {
+                swap(v[left_base + offsets_l[start_l + i]],
+                     v[right_base - offsets_r[start_r + i]]);
+            }
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+            if (num_l == 0)
+            {
+                start_l = 0;
+                left_base = first;
+            }
+            if (num_r == 0)
+            {
+                start_r = 0;
+                right_base = last;
+            }
+        } // while
+
+        // one side may still have values on the wrong side; swap them to the
+        // middle, which is where the two sides meet
+        while (num_l > 0)
+        {
+            num_l--;
+            last--;
+            swap(v[left_base + offsets_l[start_l + num_l]], v[last]);
+            first = last;
+        }
+        while (num_r > 0)
+        {
+            num_r--;
+            swap(v[right_base - offsets_r[start_r + num_r]], v[first]);
+            first++;
+            last = first;
+        }
+    }
+
+    // put the pivot between the two parts
+    const int pivot_pos = first - 1;
+    v[begin] = v[pivot_pos];
+    v[pivot_pos] = pivot;
+    return pivot_pos;
+} // partition_right
+
+// Pre-condition:
+//    the pivot is in v[begin], and v[begin - 1] == pivot with every value in
+//    the range >= v[begin - 1]
+// Post-condition:
+//    returns the final index p of the pivot; v[begin] to v[p] are == pivot
+//    and v[p + 1] to v[end - 1] are > pivot
+int partition_left(vector<int> &v, int begin, int end)
+{
+    const int pivot = v[begin];
+    int first = begin;
+    int last = end;
+
+    do
+    {
+        last--;
+        quicksort_comp_count++;
+    } while (pivot < v[last]);
+    if (last + 1 == end)
+    {
+        while (first < last)
+        {
+            first++;
+            quicksort_comp_count++;
+            if (pivot < v[first])
+                break;
+        }
+    }
+    else
+    {
+        do
+        {
+            first++;
+            quicksort_comp_count++;
+        } while (!(pivot < v[first]));
+    }
+
+    while (first < last)
+    {
+        swap(v[first], v[last]);
+        do
+        {
+            last--;
+            quicksort_comp_count++;
+        } while (pivot < v[last]);
+        do
+        {
+            first++;
+            quicksort_comp_count++;
+        } while (!(pivot < v[first]));
+    }
+
+    v[begin] = v[last];
+    v[last] = pivot;
+    return last;
+} // partition_left
+
+// Insertion sort of v[begin] to v[end - 1] that gives up after
+// partial_insertion_limit moves. Returns true if the range got sorted.
+bool partial_insertion_sort(vector<int> &v, int begin, int end)
+{
+    int moves = 0;
+    for (int i = begin + 1; i < end; i++)
+    {
+        quicksort_comp_count++;
+        if (v[i] < v[i - 1])
+        {
+            int key = v[i];
+            int j = i;
+            do
+            {
+                v[j] = v[j - 1];
+                j--;
+                quicksort_comp_count++;
+            } while (j > begin && key < v[j - 1]);
+            v[j] = key;
+            moves += i - j;
+        }
+        if (moves > partial_insertion_limit)
+            return false;
+    }
+    return true;
+}
+
+// Sorts v[begin] to v[end - 1]. If leftmost is false then v[begin - 1] is <=
+// every value in the range. bad_allowed is the number of unbalanced
+// partitions left before switching to heapsort.
+void pdqsort(vector<int> &v, int begin, int end, int bad_allowed, bool leftmost)
+{
+    // the right part is sorted by the loop instead of by recursion
+    while (true)
+    {
+        const int n = end - begin;
+        if (n < quicksort_insertion_cutoff)
+        {
+            // v[begin - 1] stops the unguarded loop
+            if (leftmost)
+                guarded_insertion_sort(v, begin, end);
+            else
+                for (int i = begin + 1; i < end; i++)
+                    unguarded_linear_insert(v, i);
+            return;
+        }
+
+        choose_pivot(v, begin, end);
+
+        // if the pivot equals the value before the range then no value in the
+        // range is smaller, so put all the values equal to it in place
+        if (!leftmost)
+        {
+            quicksort_comp_count++;
+            if (!(v[begin - 1] < v[begin]))
+            {
+                begin = partition_left(v, begin, end) + 1;
+                continue;
+            }
+        }
+
+        bool already_partitioned;
+        const int pivot_pos = partition_right(v, begin, end,
+                                              already_partitioned);
+        const int l_size = pivot_pos - begin;
+        const int r_size = end - (pivot_pos + 1);
+        if (l_size < n / 8 || r_size < n / 8)
+        {
+            bad_allowed--;
+            if (bad_allowed == 0)
+            {
+                heapsort(v, begin, end);
+                return;
+            }
+
+            // swap a few values from a quarter of the way in with the values
+            // at the ends, which is where the next pivots are chosen from
+            if (l_size >= quicksort_insertion_cutoff)
+            {
+                swap(v[begin], v[begin + l_size / 4]);
+                swap(v[pivot_pos - 1], v[pivot_pos - l_size / 4]);
+                if (l_size > quicksort_ninther_cutoff)
+                {
+                    swap(v[begin + 1], v[begin + l_size / 4 + 1]);
+                    swap(v[begin + 2], v[begin + l_size / 4 + 2]);
+                    swap(v[pivot_pos - 2], v[pivot_pos - l_size / 4 - 1]);
+                    swap(v[pivot_pos - 3], v[pivot_pos - l_size / 4 - 2]);
+                }
+            }
+            if (r_size >= quicksort_insertion_cutoff)
+            {
+                swap(v[pivot_pos + 1], v[pivot_pos + 1 + r_size / 4]);
+                swap(v[end - 1], v[end - r_size / 4]);
+                if (r_size > quicksort_ninther_cutoff)
+                {
+                    swap(v[pivot_pos + 2], v[pivot_pos + 2 + r_size / 4]);
+                    swap(v[pivot_pos + 3], v[pivot_pos + 3 + r_size / 4]);
+                    swap(v[end - 2], v[end - r_size / 4 - 1]);
+                    swap(v[end - 3], v[end - r_size / 4 - 2]);
+                }
+            }
+        }
+        else if (already_partitioned
+                 && partial_insertion_sort(v, begin, pivot_pos)
+                 && partial_insertion_sort(v, pivot_pos + 1, end))
+        {
+            return; // the range was already sorted, or nearly
+        }
+
+        pdqsort(v, begin, pivot_pos, bad_allowed, leftmost);
+        begin = pivot_pos + 1;
+        leftmost = false;
+    } // while
+} // pdqsort
+
+void pdqsort(vector<int> &v)
+{
+    // the insertion sorts count into insertion_sort_comp_count, so move those
+    // comparisons over to quicksort_comp_count
+    long insertion_comps_before = insertion_sort_comp_count;
+    pdqsort(v, 0, v.size(), log2(max<int>(2, v.size())), true);
+    quicksort_comp_count += insertion_sort_comp_count - insertion_comps_before;
+    insertion_sort_comp_count = insertion_comps_before;
+    assert(is_sorted(v));
+}
+
+// also checks that v has the same values as before
+bool pdqsort_ok(vector<int> v)
+{
+    vector<int> expected = v;
+    std::sort(expected.begin(), expected.end());
+    pdqsort(v);
+    return v == expected;
+}
+
+void test_pdqsort()
+{
+    cout << "Calling test_pdqsort ...\n";
+    assert(pdqsort_ok({}));
+    assert(pdqsort_ok({5}));
+    assert(pdqsort_ok({4, 1}));
+    assert(pdqsort_ok({4, 4, 4, 4, 4, 4}));
+    assert(pdqsort_ok({8, 7, 3, 1, 0, -5}));
+
+    // patterns that make simple quicksorts slow, in a few sizes
+    for (int n : {30, 100, 1000, 10000})
+    {
+        vector<int> sorted(n);
+        vector<int> reversed(n);
+        vector<int> equal(n, 7);
+        vector<int> few_values(n);
+        vector<int> organ_pipe(n);
+        vector<int> sawtooth(n);
+        for (int i = 0; i < n; i++)
+        {
+            sorted[i] = i;
+            reversed[i] = n - i;
+            few_values[i] = rand() % 4;
+            organ_pipe[i] = i < n / 2 ? i : n - i;
+            sawtooth[i] = i % 17;
+        }
+        vector<int> nearly_sorted = sorted;
+        swap(nearly_sorted[n / 3], nearly_sorted[n / 2]);
+
+        for (const vector<int> &v : {sorted, reversed, equal, few_values,
+                                     organ_pipe, sawtooth, nearly_sorted,
+                                     random_vector(n)})
+        {
+            assert(pdqsort_ok(v));
+        }
+    }
+
+    // heapsort is only used for bad inputs, so test it directly
+    vector<int> v = random_vector(1000);
+    heapsort(v, 100, 900);
+    assert(is_sorted(v, 100, 900));
+    cout << " ... test_pdqsort done: all tests passed\n";
+}
+
+//
+// Parallel sample sort
+//
+// Sample sort splits v into buckets such that every value in a bucket is <=
+// every value in the next bucket, and then sorts the buckets independently.
+// Unlike parallel mergesort, there is no merge at the end, which would need
+// all the threads to work on the same data again. The steps are:
+//
+// 1. Pick a random sample of v and sort it. Evenly spaced values of the sorted
+//    sample are the splitters, i.e. the boundaries between the buckets.
+// 2. Split v into one block per thread. Each thread counts how many values of
+//    its block go into each bucket.
+// 3. Add up the counts to get where each thread writes each bucket's values,
+//    and then each thread copies its block's values into place in a second
+//    vector.
+// 4. Sort the buckets with pdqsort. There are more buckets than threads, and
+//    a thread that finishes a bucket takes the next one, so threads that get
+//    small buckets do more of them.
+//
+// A value equal to a splitter goes into an extra bucket for just that
+// splitter, which never needs sorting. So if v has many copies of some value,
+// they all go into one bucket that is already sorted, instead of making one
+// bucket much bigger than the others.
+//
+// pdqsort and insertion sort count comparisons in thread_local variables, so
+// the threads don't share them; the comparisons the threads make aren't
+// counted.
+//
+
+// Vectors smaller than this are sorted by pdqsort on one thread.
+const int sample_sort_cutoff = 1 << 16;
+
+// Number of buckets for each thread, and number of samples for each bucket.
+const int buckets_per_thread = 8;
+const int samples_per_bucket = 16;
+
+// Most entries wanted in the per-thread bucket count table.
+const int max_table_entries = 1 << 20;
+
+// Most threads sample sort uses, so that 2 * k - 1 buckets always fit in 16
+// bits.
+const int max_sample_threads = 4096;
+
+// Calls f(i) for every i from 0 to tasks - 1, using up to threads threads.
+// The threads share a counter, and each takes the next task that hasn't been
+// started until all of them have been.
+void parallel_for(int tasks, int threads, const function<void(int)> &f)
+{
+    atomic<int> next(0);
+    auto worker = [&]()
+    {
+        for (int i = next++; i < tasks; i = next++)
+        {
+            f(i);
+        }
+    };
+
+    vector<thread> pool;
+    for (int t = 1; t < min(threads, tasks); t++)
+    {
+        pool.push_back(thread(worker));
+    }
+    worker(); // this thread works too
+    for (thread &t : pool)
+    {
+        t.join();
+    }
+}
+
+// Returns the bucket x goes in: bucket 2 * i + 1 holds the values equal to
+// splitters[i], and bucket 2 * i holds the values between splitters[i - 1] and
+// splitters[i].
+//
+// The binary search has no if statements in its loop (the ?: can be done by a
+// conditional move instruction), since every value goes the way of a coin flip
+// and the CPU would guess wrong about half the time.
+int sample_sort_bucket(int x, const vector<int> &splitters)
+{
+    if (splitters.empty())
+        return 0;
+    const int *base = splitters.data();
+    int n = splitters.size();
+    while (n > 1)
+    {
+        int half = n / 2;
+        base = base[half] < x ? base + half : base;
+        n -= half;
+    }
+    int i = (base - splitters.data()) + (*base < x);
+    return 2 * i + (i < splitters.size() && splitters[i] == x);
+}
+
+void sample_sort(vector<int> &v, int threads)
+{
+    // more threads than a few per core only add overhead, and the tables below
+    // get bigger with every thread
+    threads = min({threads, 4 * cmpt::default_threads(), max_sample_threads});
+    const int n = v.size();
+    if (threads <= 1 || n < sample_sort_cutoff)
+    {
+        pdqsort(v);
+        return;
+    }
+
+    // 1. choose the splitters from a sorted random sample; duplicate splitters
+    // are removed, since their values all go into the same equal bucket.
+    // There are at most 2 * k - 1 buckets, so a bucket number fits in 16
+    // bits. The count and start tables in steps 2 and 3 have one entry per
+    // thread per bucket, which grows as threads squared, so k is also kept to
+    // about max_table_entries / threads (but at least one bucket per thread).
+    const int k = min(threads * buckets_per_thread,
+                      max(threads, max_table_entries / threads));
+    mt19937 random(n);
+    uniform_int_distribution<int> index(0, n - 1);
+    vector<int> sample(k * samples_per_bucket);
+    for (int &x : sample)
+    {
+        x = v[index(random)];
+    }
+    pdqsort(sample);
+    vector<int> splitters;
+    for (int i = 1; i < k; i++)
+    {
+        splitters.push_back(sample[i * samples_per_bucket]);
+    }
+    splitters.erase(unique(splitters.begin(), splitters.end()),
+                    splitters.end());
+    const int buckets = 2 * splitters.size() + 1;
+
+    // 2. count[b][j] is the number of values of block b that go in bucket j;
+    // each value's bucket is saved so step 3 doesn't need to search again
+    const int block_size = (n + threads - 1) / threads;
+    vector<vector<int>> count(threads, vector<int>(buckets, 0));
+    vector<uint16_t> bucket(n);
+    parallel_for(threads, threads, [&](int b)
+    {
+        int end = min(n, (b + 1) * block_size);
+        for (int i = b * block_size; i < end; i++)
+        {
+            bucket[i] = sample_sort_bucket(v[i], splitters);
+            count[b][bucket[i]]++;
+        }
+    });
+
+    // 3. start[b][j] is where block b writes its first value of bucket j; all
+    // of bucket j goes before bucket j + 1, and within a bucket block 0's
+    // values go first
+    vector<vector<int>> start(threads, vector<int>(buckets, 0));
+    vector<int> bucket_begin(buckets + 1, 0);
+    int pos = 0;
+    for (int j = 0; j < buckets; j++)
+    {
+        bucket_begin[j] = pos;
+        for (int b = 0; b < threads; b++)
+        {
+            start[b][j] = pos;
+            pos += count[b][j];
+        }
+    }
+    bucket_begin[buckets] = n;
+
+    vector<int> out(n);
+    parallel_for(threads, threads, [&](int b)
+    {
+        int end = min(n, (b + 1) * block_size);
+        for (int i = b * block_size; i < end; i++)
+        {
+            out[start[b][bucket[i]]++] = v[i];
+        }
+    });
+
+    // 4. sort the buckets between splitters (the even ones), biggest first,
+    // so a big bucket isn't left until the end when the other threads are
+    // idle
+    vector<int> order;
+    for (int j = 0; j < buckets; j += 2)
+    {
+        order.push_back(j);
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        return bucket_begin[a + 1] - bucket_begin[a] >
+               bucket_begin[b + 1] - bucket_begin[b];
+    });
+    parallel_for(order.size(), threads, [&](int t)
+    {
+        int j = order[t];
+        int begin = bucket_begin[j];
+        int end = bucket_begin[j + 1];
+        pdqsort(out, begin, end, log2(max(2, end - begin)), true);
+    });
+
+    v.swap(out);
+    assert(is_sorted(v));
+} // sample_sort
+
+void sample_sort(vector<int> &v)
+{
+    sample_sort(v, sort_threads);
+}
+
+void test_sample_sort()
+{
+    cout << "Calling test_sample_sort ...\n";
+    vector<int> few_values(300000);
+    vector<int> sorted(300000);
+    for (int i = 0; i < few_values.size(); i++)
+    {
+        few_values[i] = rand() % 3;
+        sorted[i] = i;
+    }
+    for (const vector<int> &v : {random_vector(300000), few_values, sorted,
+                                 vector<int>(300000, 7), random_vector(100)})
+    {
+        vector<int> expected = v;
+        std::sort(expected.begin(), expected.end());
+        for (int threads = 1; threads <= 8; threads++)
+        {
+            vector<int> w = v;
+            sample_sort(w, threads);
+            assert(w == expected);
+        }
+    }
+    cout << " ... test_sample_sort done: all tests passed\n";
+}
+
+// Times sample sort on the same random vector of length n with 1, 2, 4, ...
+// threads, up to sort_threads.
+void do_scaling_test(int n, cmpt::Bench &bench)
+{
+    vector<int> data = random_vector(n);
+    vector<int> v;
+    vector<int> thread_counts;
+    for (int t = 1; t < sort_threads; t *= 2)
+    {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(sort_threads);
+
+    for (int t : thread_counts)
+    {
+        bench.run(
+            "Sample sort (threads = " + to_string(t) + ")", n,
+            [&]() { v = data; },
+            [&]() { sample_sort(v, t); });
+    }
+} // do_scaling_test
+
+// A sorting function to be compared by do_sort_test. comp_count points to the
+// global variable the function increments every time it does a comparison
+// (or, for radix sort, every time it reads or moves an element). Slow sorts
+// set max_n so they are skipped for big n; 0 means no limit.
+struct Sort_algorithm
+{
+    string name;
+    void (*sort)(vector<int> &);
+    long *comp_count;
+    int max_n;
+};
+
+vector<Sort_algorithm> all_sorts = {
+    {"Insertion sort", insertion_sort, &insertion_sort_comp_count, 20000},
+    {"Mergesort", mergesort, &mergesort_comp_count, 20000},
+    {"Mergesort (buffered)", mergesort_buffered, &mergesort_comp_count, 0},
+    {"Mergesort (bottom-up)", mergesort_bottom_up, &mergesort_comp_count, 0},
+    {"Mergesort (hybrid)", mergesort_hybrid, &mergesort_comp_count, 0},
+    {"Mergesort (parallel)", mergesort_parallel, nullptr, 0},
+    {"Binary insertion sort", binary_insertion_sort,
+     &insertion_sort_comp_count, 100000},
+    {"Guarded insertion sort", guarded_insertion_sort,
+     &insertion_sort_comp_count, 20000},
+    {"Quicksort (pdqsort)", pdqsort, &quicksort_comp_count, 0},
+    {"Sample sort (parallel)", sample_sort, nullptr, 0},
+    {"Radix sort", radix_sort, &radix_sort_op_count, 0},
+};
+
+// Times every algorithm in all_sorts on the same random vector of length n,
+// using bench. Each algorithm sorts its own copy of the vector.
+void do_sort_test(int n, cmpt::Bench &bench)
+{
+    vector<int> data = random_vector(n);
+    vector<int> v;
+    for (const Sort_algorithm &alg : all_sorts)
+    {
+        if (alg.max_n > 0 && n > alg.max_n)
+            continue;
+        bench.run(
+            alg.name, n,
+            [&]() { v = data; },
+            [&]() { alg.sort(v); },
+            alg.comp_count);
+    }
+} // do_sort_test
+
+//
+// Binary search
+//
+// Pre-condition:
+//   v[begin] to v[end - 1] is in ascending sorted order
+// Post-condition:
+//   returns an index i such that v[i] == x and
+//   begin <= i < end;
+//   if x is not found, -1 is returned
+int iterative_binary_search(int x, const vector<int> &v,
+                            int begin, int end)
+{
+    while (begin < end)
+    {
+        int mid = (begin + end) / 2;
+        if (v[mid] == x)
+        { // found x!
+            return mid;
+        }
+        else if (x < v[mid])
+        {
+            end = mid;
+        }
+        else // x > v[mid]
+        {
+            begin = mid + 1;
+        }
+    }
+    return -1; // x not found
+}
+
+// Pre-condition:
+//    v is in ascending sorted order
+// Post-condition:
+//    returns an index i such that v[i] == x; if x is
+//    not in v, -1 is returned
+int iterative_binary_search(int x, const vector<int> &v)
+{
+    return iterative_binary_search(x, v, 0, v.size());
+}
+
+void test_iterative_binary_search()
+{
+    cout << "Calling test_iterative_binary_search ...\n";
+    vector<int> empty = {};
+    vector<int> one = {5};
+    vector<int> two = {2, 7};
+    vector<int> three = {2, 5, 7};
+
+    assert(iterative_binary_search(5, empty) == -1);
+    assert(iterative_binary_search(5, one) == 0);
+    assert(iterative_binary_search(2, one) == -1);
+
+    assert(iterative_binary_search(2, two) == 0);
+    assert(iterative_binary_search(7, two) == 1);
+    assert(iterative_binary_search(1, two) == -1);
+    assert(iterative_binary_search(5, two) == -1);
+    assert(iterative_binary_search(10, two) == -1);
+
+    assert(iterative_binary_search(2, three) == 0);
+    assert(iterative_binary_search(5, three) == 1);
+    assert(iterative_binary_search(7, three) == 2);
+    assert(iterative_binary_search(1, three) == -1);
+    assert(iterative_binary_search(3, three) == -1);
+    assert(iterative_binary_search(6, three) == -1);
+    assert(iterative_binary_search(10, three) == -1);
+
+    cout << "... test_iterative_binary_search done: all tests passed\n";
+}
+
+int recursive_binary_search(int x, const vector<int> &v,
+                            int begin, int end)
+{
+    const int n = end - begin;
+
+    // if the sub-vector being searched is empty,
+    // then x is not in it
+    if (n <= 0)
+        return -1; // x not found
+
+    int mid = (begin + end) / 2;
+    if (x == v[mid])
+    {
+        return mid;
+    }
+    else if (x < v[mid])
+    {
+        return recursive_binary_search(x, v, begin, mid);
+    }
+    else
+    {
+        return recursive_binary_search(x, v, mid + 1, end);
+    }
+}
+
+// Pre-condition:
+//    v is in ascending sorted order
+// Post-condition:
+//    returns an index i such that v[i] == x;
+//    if x is not in v, -1 is returned
+int recursive_binary_search(int x, const vector<int> &v)
+{
+    return recursive_binary_search(x, v, 0, v.size());
+}
+
+void test_recursive_binary_search()
+{
+    cout << "Calling test_recursive_binary_search ...\n";
+    vector<int> empty = {};
+    vector<int> one = {5};
+    vector<int> two = {2, 7};
+    vector<int> three = {2, 5, 7};
+
+    assert(recursive_binary_search(5, empty) == -1);
+    
+    assert(recursive_binary_search(5, one) == 0);
+    assert(recursive_binary_search(2, one) == -1);
+
+    assert(recursive_binary_search(2, two) == 0);
+    assert(recursive_binary_search(7, two) == 1);
+    assert(recursive_binary_search(1, two) == -1);
+    assert(recursive_binary_search(5, two) == -1);
+    assert(recursive_binary_search(10, two) == -1);
+
+    assert(recursive_binary_search(2, three) == 0);
+    assert(recursive_binary_search(5, three) == 1);
+    assert(recursive_binary_search(7, three) == 2);
+    assert(recursive_binary_search(1, three) == -1);
+    assert(recursive_binary_search(3, three) == -1);
+    assert(recursive_binary_search(6, three) == -1);
+    assert(recursive_binary_search(10, three) == -1);
+
+    cout << "... test_recursive_binary_search done: all tests passed\n";
+}
+
+// Checks that the templates in cmpt_algorithm.h give the same results as the
+// int versions in this file.
+void test_cmpt_algorithm()
+{
+    cout << "Calling test_cmpt_algorithm ...\n";
+    vector<vector<int>> tests = {
+        {},
+        {5},
+        {4, 1},
+        {4, 4, 4, 4, 4, 4},
+        {8, 7, 3, 1, 0, -5},
+        {0, 2147483647, -2147483647 - 1, -1, 1, 256, -256},
+    };
+    tests.push_back(random_vector(500));
+    vector<int> dups;
+    for (int i = 0; i < 500; i++)
+    {
+        dups.push_back(rand() % 20 - 10);
+    }
+    tests.push_back(dups);
+
+    for (const vector<int> &v : tests)
+    {
+        vector<int> expected = v;
+        insertion_sort(expected);
+
+        vector<int> a = v;
+        cmpt::insertion_sort(a.begin(), a.end());
+        assert(a == expected);
+        a = v;
+        cmpt::binary_insertion_sort(a.begin(), a.end());
+        assert(a == expected);
+        a = v;
+        cmpt::mergesort(a.begin(), a.end());
+        assert(a == expected);
+        a = v;
+        cmpt::generic_sort(a.begin(), a.end()); // uses radix sort
+        assert(a == expected);
+        a = v;
+        cmpt::generic_sort(a.data(), a.data() + a.size()); // pointers work too
+        assert(a == expected);
+        assert(cmpt::generic_is_sorted(a.begin(), a.end()));
+
+        // sorting with > gives the reverse order
+        a = v;
+        // uses mergesort
+        cmpt::generic_sort(a.begin(), a.end(), greater<int>());
+        assert(equal(a.rbegin(), a.rend(), expected.begin()));
+
+        // binary search returns the same index as the lecture version, even
+        // when there are duplicates
+        for (int x = -12; x <= 12; x++)
+        {
+            int i = cmpt::generic_binary_search(expected.begin(),
+                                                expected.end(), x);
+            assert(i == iterative_binary_search(x, expected));
+        }
+        for (int x : expected)
+        {
+            int i = cmpt::generic_binary_search(expected.begin(),
+                                                expected.end(), x);
+            assert(i == iterative_binary_search(x, expected));
+        }
+    }
+
+    // chars use counting sort, with negative chars first if char is signed
+    string s = "one, two, three\x80\x7f";
+    string t = s;
+    cmpt::generic_sort(s.begin(), s.end());
+    cmpt::insertion_sort(t.begin(), t.end());
+    assert(s == t);
+
+    cout << " ... test_cmpt_algorithm done: all tests passed\n";
+}
+
+// int main()
+//
+// Usage:
+//
+//   > ./sorting n
+//
+// times all the sorts on random vectors of length n, and prints a table of the
+// results.
+//
+//   > ./sorting n max_n
+//
+// does the same for n, 2n, 4n, ... up to max_n. Put --csv or --json before n
+// to print the results in that format instead of as a table, e.g.:
+//
+//   > ./sorting --csv 1000 1000000 > results.csv
+//
+// -j N sets the number of threads for the parallel sorts (the default is the
+// number of cores).
+//
+//   > ./sorting --calibrate
+//
+// measures the best cutoff between insertion sort and mergesort for the hybrid
+// mergesort, and saves it in sorting.cfg in the same directory as the program.
+// Afterwards, every run of ./sorting uses that cutoff.
+//
+//   > ./sorting --scaling -j 16 100000000
+//
+// times only sample sort, with 1, 2, 4, ... up to N threads, and prints how
+// many times faster than 1 thread each is (the speedup).
+//
+int main(int argc, char *argv[])
+{
+    sorting_config_file =
+        (filesystem::path(argv[0]).parent_path() / "sorting.cfg").string();
+    load_sorting_config();
+
+    string format = "table";
+    bool scaling = false;
+    vector<int> sizes;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--csv" || arg == "--json")
+        {
+            format = arg.substr(2);
+        }
+        else if (arg == "--calibrate")
+        {
+            insertion_sort_cutoff = measure_insertion_cutoff();
+            save_sorting_config();
+            cout << "insertion_sort_cutoff = " << insertion_sort_cutoff
+                 << " (saved in " << sorting_config_file << ")\n";
+            return 0;
+        }
+        else if (arg == "--scaling")
+        {
+            scaling = true;
+        }
+        else if (arg == "-j" && i + 1 < argc)
+        {
+            i++;
+            sort_threads = max(1, atoi(argv[i]));
+        }
+        else
+        {
+            sizes.push_back(atoi(argv[i]));
+        }
+    }
+    if (sizes.size() < 1 || sizes.size() > 2)
+    {
+        cout << "Usage: " << argv[0]
+             << " [--csv | --json] [--scaling] [-j N] n [max_n]\n"
+             << "       " << argv[0] << " --calibrate\n";
         return 1;
     }
 
-    int n = atoi(argv[1]);
-    do_sort_test(n);
+    int n = sizes[0];
+    int max_n = sizes.back();
+
+    cmpt::Bench bench;
+    for (long size : cmpt::sweep(n, max_n))
+    {
+        if (scaling)
+            do_scaling_test(size, bench);
+        else
+            do_sort_test(size, bench);
+    }
+
+    if (format == "csv")
+        bench.print_csv(cout);
+    else if (format == "json")
+        bench.print_json(cout);
+    else
+        bench.print_table(cout);
+
+    // the first result for each n is the 1 thread time
+    if (scaling && format == "table")
+    {
+        cout << "\n";
+        double one_thread = 0;
+        for (const cmpt::Bench_result &r : bench.get_results())
+        {
+            if (r.name == "Sample sort (threads = 1)")
+                one_thread = r.median();
+            cout << r.name << ", n = " << r.n << ": speedup "
+                 << one_thread / r.median() << "\n";
+        }
+    }
 
     // test_insertion_sort();
     // test_mergesort();
+    // test_mergesort_buffered();
+    // test_radix_sort();
+    // test_binary_insertion_sort();
+    // test_mergesort_parallel();
+    // test_selection();
+    // test_pdqsort();
+    // test_sample_sort();
+    // test_network_sort();
     // test_iterative_binary_search();
     // test_recursive_binary_search();
+    // test_cmpt_algorithm();
 }